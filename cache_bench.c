@@ -0,0 +1,667 @@
+/* Description: Benchmarks for the cache simulator.
+ *   cache_bench scale          Cost of one access as the cache grows,
+ *                              which should stay flat.
+ *   cache_bench probe          Cost of a hit as the associativity
+ *                              grows, up to fully associative. Build
+ *                              once more with -DCACHE_SIM_NO_SIMD to
+ *                              compare against the scalar way search.
+ *   cache_bench parse [file]   Trace parsing throughput in GB/s. A
+ *                              synthetic trace is written and timed
+ *                              as text and binary when no file is
+ *                              given.
+ *   cache_bench suite [-n N] [-w LIST] [-c LIST] [-b LIST] [-a LIST]
+ *    [-p LIST]                 Throughput of every synthetic workload
+ *                              on every combination of cache size,
+ *                              block size, associativity, and policy,
+ *                              with N accesses each. One tab separated
+ *                              row per run, meant to be kept and
+ *                              compared over time. Each run is forked
+ *                              off so that its peak RSS is its own.
+ *  With no arguments every benchmark but the suite is run.
+ *
+ *  Build with make, or:
+ *   cc -O2 -DCACHE_SIM_NO_MAIN -o cache_bench cache_sim.c cache_bench.c \
+ *    workload.c trace.c hashmap.c shadow.c policy.c profile.c -lm
+ */
+
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "cache_sim.h"
+#include "trace.h"
+#include "workload.h"
+
+#define BENCH_ACCESSES	2000000
+#define BENCH_MM_SIZE	(1 << 26)
+#define BENCH_LINES		20000000
+#define BENCH_PROBE_SIZE	(1 << 18)
+#define BENCH_SUITE_ACCESSES	(1 << 20)
+#define BENCH_LIST_MAX		16
+
+/* Structs */
+
+/* BenchList
+ *
+ * Values of one axis of the suite's matrix.
+ *
+ * @param	count			Number of values
+ * @param	values			The values
+ */
+
+struct BenchList_ {
+	int count;
+	int values[BENCH_LIST_MAX];
+};
+
+/* BenchResult
+ *
+ * Results of one suite run, handed from the child that ran it.
+ *
+ * @param	hits			# of hits
+ * @param	elapsed			Seconds spent in the timed loop
+ */
+
+struct BenchResult_ {
+	long hits;
+	double elapsed;
+};
+
+/* benchNow
+ *
+ * Reads the monotonic clock.
+ *
+ * @return	seconds			Current time in seconds
+ */
+
+static double benchNow(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+/* benchScale
+ *
+ * Runs the same random access pattern against caches of growing size
+ * and prints the time per access for each one. The working set is
+ * twice the cache size so every run sees a mix of hits and misses.
+ *
+ * @param	addrs			Scratch array of BENCH_ACCESSES addresses
+ *
+ * @return	void
+ */
+
+static void benchScale(unsigned int *addrs) {
+	static const int assoc[2] = {1, 4};
+	Cache cache;
+	unsigned int seed;
+	double start, elapsed;
+	int cache_size, hits, i, j;
+
+	printf("cache_size\tnSA\taccesses\thits\tns_per_access\tbytes_per_block\n");
+	for(j = 0; j < 2; j++) {
+		for(cache_size = 1024; cache_size <= (1 << 20); cache_size <<= 2) {
+			seed = 2463534242u;
+			for(i = 0; i < BENCH_ACCESSES; i++) {
+				seed ^= seed << 13;
+				seed ^= seed >> 17;
+				seed ^= seed << 5;
+				addrs[i] = seed % (unsigned int)(2 * cache_size);
+			}
+
+			cache = cacheCreate(cache_size, 64, CACHE_LRU);
+			cacheSetGeometry(cache, BENCH_MM_SIZE, assoc[j]);
+
+			hits = 0;
+			start = benchNow();
+			for(i = 0; i < BENCH_ACCESSES; i++) {
+				if(i & 1) {
+					hits += cacheWriteAddr(cache, addrs[i]);
+				}
+				else {
+					hits += cacheReadAddr(cache, addrs[i]);
+				}
+			}
+			elapsed = benchNow() - start;
+
+			printf("%d\t%d\t%d\t%d\t%.2f\t%.2f\n", cache_size, assoc[j],
+				BENCH_ACCESSES, hits, elapsed * 1e9 / BENCH_ACCESSES,
+				(double)cacheFootprint(cache) / (cache_size / 64));
+			cacheDestroy(cache);
+		}
+	}
+}
+
+/* benchProbe
+ *
+ * Fills a cache of BENCH_PROBE_SIZE bytes completely, then times
+ * random accesses to the blocks it holds, for every associativity
+ * from direct mapped to fully associative. Every access hits, so the
+ * time is spent finding the way.
+ *
+ * @param	addrs			Scratch array of BENCH_ACCESSES addresses
+ *
+ * @return	void
+ */
+
+static void benchProbe(unsigned int *addrs) {
+	Cache cache;
+	unsigned int seed;
+	double start, elapsed;
+	int blocks, nSA, hits, i;
+
+	blocks = BENCH_PROBE_SIZE / 64;
+	seed = 2463534242u;
+	for(i = 0; i < BENCH_ACCESSES; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		addrs[i] = (seed % (unsigned int)blocks) * 64;
+	}
+
+	printf("cache_size\tnSA\taccesses\thits\tns_per_probe\n");
+	for(nSA = 1; nSA <= blocks; nSA <<= 1) {
+		cache = cacheCreate(BENCH_PROBE_SIZE, 64, CACHE_LRU);
+		cacheSetGeometry(cache, BENCH_MM_SIZE, nSA);
+		for(i = 0; i < blocks; i++) {
+			cacheReadAddr(cache, (unsigned int)i * 64);
+		}
+
+		hits = 0;
+		start = benchNow();
+		for(i = 0; i < BENCH_ACCESSES; i++) {
+			hits += cacheReadAddr(cache, addrs[i]);
+		}
+		elapsed = benchNow() - start;
+
+		printf("%d\t%d\t%d\t%d\t%.2f\n", BENCH_PROBE_SIZE, nSA, BENCH_ACCESSES, hits,
+			elapsed * 1e9 / BENCH_ACCESSES);
+		cacheDestroy(cache);
+	}
+}
+
+/* benchWriteTrace
+ *
+ * Writes a synthetic text trace to a temporary file, with half of the
+ * addresses in decimal and half in hexadecimal. Most accesses walk
+ * forward through memory and one in ten jumps somewhere random.
+ *
+ * @param	path			Buffer of at least 32 bytes for the file name
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int benchWriteTrace(char *path) {
+	FILE *file;
+	unsigned int seed = 88172645u, address = 0;
+	int fd, i;
+
+	strcpy(path, "/tmp/cache_bench_XXXXXX");
+	fd = mkstemp(path);
+	if(fd < 0) {
+		return(0);
+	}
+	file = fdopen(fd, "w");
+	if(file == NULL) {
+		close(fd);
+		return(0);
+	}
+
+	fprintf(file, "%d\n\n", BENCH_LINES);
+	for(i = 0; i < BENCH_LINES; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		address = (seed % 10 == 0) ? seed : address + 64;
+		if(i & 1) {
+			fprintf(file, "%c 0x%x\n", (seed & 4) ? 'W' : 'R', address);
+		}
+		else {
+			fprintf(file, "%c %u\n", (seed & 4) ? 'W' : 'R', address);
+		}
+	}
+	fclose(file);
+
+	return(1);
+}
+
+/* benchConvert
+ *
+ * Converts a trace into a binary trace in a temporary file.
+ *
+ * @param	filename		Trace to convert
+ * @param	path			Buffer of at least 32 bytes for the file name
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int benchConvert(char *filename, char *path) {
+	Trace trace;
+	TraceWriter writer;
+	char mode;
+	unsigned long long address;
+	int fd;
+
+	strcpy(path, "/tmp/cache_bench_XXXXXX");
+	fd = mkstemp(path);
+	if(fd < 0) {
+		return(0);
+	}
+	close(fd);
+
+	trace = traceOpen(filename);
+	writer = traceWriterOpen(path);
+	if(trace == NULL || writer == NULL) {
+		traceClose(trace);
+		traceWriterClose(writer);
+		return(0);
+	}
+	while(traceNext(trace, &mode, &address)) {
+		traceWrite(writer, mode, address, traceCore(trace));
+	}
+	traceClose(trace);
+
+	return(traceWriterClose(writer));
+}
+
+/* benchParseFile
+ *
+ * Times how fast one trace file can be parsed, without simulating it,
+ * and prints a row of results.
+ *
+ * @param	filename		Trace to parse
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int benchParseFile(char *filename) {
+	Trace trace;
+	struct stat st;
+	char mode;
+	unsigned long long address, sum = 0;
+	long count = 0;
+	double start, elapsed;
+
+	if(stat(filename, &st) != 0 || (trace = traceOpen(filename)) == NULL) {
+		fprintf(stderr, "Could not open trace %s.\n", filename);
+		return(1);
+	}
+
+	start = benchNow();
+	while(traceNext(trace, &mode, &address)) {
+		sum += address + mode;
+		count++;
+	}
+	elapsed = benchNow() - start;
+	traceClose(trace);
+
+	printf("%s\t%lld\t%ld\t%.3f\t%.3f\t%.1f\t%llu\n", filename, (long long)st.st_size,
+		count, elapsed, st.st_size / elapsed * 1e-9, count / elapsed * 1e-6, sum);
+
+	return(0);
+}
+
+/* benchParse
+ *
+ * Times trace parsing. With no file, a synthetic text trace is written
+ * and timed along with its binary conversion.
+ *
+ * @param	filename		Trace to parse, or NULL for a synthetic one
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int benchParse(char *filename) {
+	char text[32], binary[32];
+	int status;
+
+	printf("trace\tbytes\taccesses\tseconds\tGB_per_s\tM_accesses_per_s\tchecksum\n");
+	if(filename != NULL) {
+		return(benchParseFile(filename));
+	}
+
+	if(!benchWriteTrace(text)) {
+		fprintf(stderr, "Could not write synthetic trace.\n");
+		return(1);
+	}
+	status = benchParseFile(text);
+	if(benchConvert(text, binary)) {
+		status |= benchParseFile(binary);
+	}
+	else {
+		fprintf(stderr, "Could not convert synthetic trace.\n");
+		status = 1;
+	}
+	unlink(text);
+	unlink(binary);
+
+	return(status);
+}
+
+/* benchPolicy
+ *
+ * Finds a replacement policy by full name, ignoring case.
+ *
+ * @param	name			Name of the policy, such as LRU
+ *
+ * @return	success			One of the CACHE_ policy numbers
+ * @return	failure			-1
+ */
+
+static int benchPolicy(const char *name) {
+	const char *policy;
+	int i;
+
+	for(i = 1; strcmp(policy = cachePolicyName(i), "N/A") != 0; i++) {
+		if(strcasecmp(name, policy) == 0) {
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/* benchList
+ *
+ * Reads a comma separated list of numbers, workload names, or policy
+ * names into a BenchList.
+ *
+ * @param	text			The list
+ * @param	list			Filled in with the values
+ * @param	kind			'n' for numbers, 'w' for workloads, 'p' for
+ *							policies
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int benchList(char *text, struct BenchList_ *list, int kind) {
+	char *item, *end;
+	long value;
+
+	list->count = 0;
+	for(item = strtok(text, ","); item != NULL; item = strtok(NULL, ",")) {
+		if(list->count == BENCH_LIST_MAX) {
+			return(0);
+		}
+		if(kind == 'w') {
+			value = workloadParse(item);
+		}
+		else if(kind == 'p') {
+			value = benchPolicy(item);
+		}
+		else {
+			value = strtol(item, &end, 0);
+			if(*end != '\0' || value <= 0 || value > (1L << 30)) {
+				value = -1;
+			}
+		}
+		if(value < 0) {
+			return(0);
+		}
+		list->values[list->count++] = (int)value;
+	}
+
+	return(list->count > 0);
+}
+
+/* benchSuiteRun
+ *
+ * Times one workload on one cache. OPT's next uses are worked out
+ * before the clock starts.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	policy			One of the CACHE_ policy numbers
+ * @param	addresses		Accesses of the workload
+ * @param	modes			Modes of the workload, R or W
+ * @param	next_use		Scratch array of count + 1 next uses
+ * @param	count			Number of accesses
+ * @param	result			Filled in with the hits and time
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int benchSuiteRun(int cache_size, int block_size, int nSA, int policy,
+	const unsigned long long *addresses, const char *modes, unsigned long long *next_use,
+	long count, struct BenchResult_ *result) {
+	Cache cache;
+	double start;
+	long i, hits = 0;
+
+	cache = cacheCreate(cache_size, block_size, policy);
+	if(cache == NULL) {
+		return(0);
+	}
+	cacheSetGeometry(cache, BENCH_MM_SIZE, nSA);
+	if(policy == CACHE_OPT && !cacheNextUse(cache, addresses, modes, count, next_use)) {
+		cacheDestroy(cache);
+		return(0);
+	}
+
+	start = benchNow();
+	for(i = 0; i < count; i++) {
+		hits += cacheAccessNext(cache, addresses[i], modes[i] == 'W',
+			(policy == CACHE_OPT) ? next_use[i] : CACHE_NEVER);
+	}
+	result->elapsed = benchNow() - start;
+	result->hits = hits;
+	cacheDestroy(cache);
+
+	return(1);
+}
+
+/* benchSuiteFork
+ *
+ * Runs one workload on one cache in a child process and prints its
+ * row. The child's peak RSS, read back through wait4, counts the
+ * workload it inherits and this cache, but no cache of an earlier row.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	policy			One of the CACHE_ policy numbers
+ * @param	addresses		Accesses of the workload
+ * @param	modes			Modes of the workload, R or W
+ * @param	next_use		Scratch array of count + 1 next uses
+ * @param	count			Number of accesses
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int benchSuiteFork(int workload, int cache_size, int block_size, int nSA, int policy,
+	const unsigned long long *addresses, const char *modes, unsigned long long *next_use,
+	long count) {
+	struct BenchResult_ result;
+	struct rusage usage;
+	pid_t pid;
+	int fds[2], status, ok;
+
+	if(pipe(fds) != 0) {
+		return(0);
+	}
+	fflush(stdout);
+	pid = fork();
+	if(pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return(0);
+	}
+	if(pid == 0) {
+		close(fds[0]);
+		ok = benchSuiteRun(cache_size, block_size, nSA, policy, addresses, modes, next_use,
+			count, &result)
+			&& write(fds[1], &result, sizeof(result)) == (ssize_t)sizeof(result);
+		_exit(ok ? 0 : 1);
+	}
+
+	close(fds[1]);
+	ok = (read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result));
+	close(fds[0]);
+	if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0
+		|| !ok) {
+		return(0);
+	}
+
+	printf("%s\t%d\t%d\t%d\t%s\t%ld\t%ld\t%.6f\t%.0f\t%.2f\t%ld\n", workloadName(workload),
+		cache_size, block_size, nSA, cachePolicyName(policy), count, result.hits, result.elapsed,
+		(result.elapsed > 0) ? count / result.elapsed : 0.0, result.elapsed * 1e9 / count,
+		(long)usage.ru_maxrss);
+
+	return(1);
+}
+
+/* benchSuite
+ *
+ * Runs every synthetic workload on every combination of the given
+ * cache sizes, block sizes, associativities, and policies. Each
+ * workload is generated once per cache and block size, outside the
+ * timed loop. Combinations that do not make a cache are skipped.
+ *
+ * @param	argc			Argument count, after "suite"
+ * @param	argv			Arguments, after "suite"
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int benchSuite(int argc, char **argv) {
+	struct BenchList_ workloads = {6, {WORKLOAD_SEQUENTIAL, WORKLOAD_STRIDED, WORKLOAD_UNIFORM,
+		WORKLOAD_ZIPF, WORKLOAD_CHASE, WORKLOAD_LARGE}};
+	struct BenchList_ cache_sizes = {2, {1 << 14, 1 << 18}};
+	struct BenchList_ block_sizes = {2, {32, 64}};
+	struct BenchList_ assocs = {2, {1, 8}};
+	struct BenchList_ policies = {5, {CACHE_LRU, CACHE_FIFO, CACHE_RANDOM, CACHE_PLRU,
+		CACHE_SRRIP}};
+	unsigned long long *addresses;
+	unsigned long long *next_use;
+	char *modes;
+	long count = BENCH_SUITE_ACCESSES;
+	int w, c, b, a, p, opt, ok = 1, status = 0;
+
+	optind = 1;
+	while(ok && (opt = getopt(argc, argv, "n:w:c:b:a:p:")) != -1) {
+		switch(opt) {
+			case 'n':
+				count = strtol(optarg, NULL, 0);
+				ok = (count > 0);
+				break;
+			case 'w':
+				ok = benchList(optarg, &workloads, 'w');
+				break;
+			case 'c':
+				ok = benchList(optarg, &cache_sizes, 'n');
+				break;
+			case 'b':
+				ok = benchList(optarg, &block_sizes, 'n');
+				break;
+			case 'a':
+				ok = benchList(optarg, &assocs, 'n');
+				break;
+			case 'p':
+				ok = benchList(optarg, &policies, 'p');
+				break;
+			default:
+				ok = 0;
+				break;
+		}
+	}
+	if(!ok || optind < argc) {
+		fprintf(stderr, "Usage: cache_bench suite [-n N] [-w LIST] [-c LIST] [-b LIST] [-a LIST] [-p LIST]\n");
+		return(1);
+	}
+
+	addresses = (unsigned long long *) malloc(sizeof(unsigned long long) * count);
+	modes = (char *) malloc(count);
+	next_use = (unsigned long long *) malloc(sizeof(unsigned long long) * (count + 1));
+	if(addresses == NULL || modes == NULL || next_use == NULL) {
+		fprintf(stderr, "Could not allocate benchmark addresses.\n");
+		free(addresses);
+		free(modes);
+		free(next_use);
+		return(1);
+	}
+
+	printf("workload\tcache_size\tblock_size\tnSA\tpolicy\taccesses\thits\tseconds\taccesses_per_s\tns_per_access\tpeak_rss_kb\n");
+	for(w = 0; w < workloads.count; w++) {
+		for(c = 0; c < cache_sizes.count; c++) {
+			for(b = 0; b < block_sizes.count; b++) {
+				if(cache_sizes.values[c] % block_sizes.values[b] != 0
+					|| !workloadGenerate(workloads.values[w], addresses, modes, count, BENCH_MM_SIZE,
+					cache_sizes.values[c], block_sizes.values[b], 2463534242u)) {
+					continue;
+				}
+				for(a = 0; a < assocs.count; a++) {
+					if((cache_sizes.values[c] / block_sizes.values[b]) % assocs.values[a] != 0) {
+						continue;
+					}
+					for(p = 0; p < policies.count; p++) {
+						if(!benchSuiteFork(workloads.values[w], cache_sizes.values[c],
+							block_sizes.values[b], assocs.values[a], policies.values[p],
+							addresses, modes, next_use, count)) {
+							fprintf(stderr, "Could not run %s on a %d byte cache.\n",
+								workloadName(workloads.values[w]), cache_sizes.values[c]);
+							status = 1;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	free(addresses);
+	free(modes);
+	free(next_use);
+	return(status);
+}
+
+int main(int argc, char **argv) {
+	unsigned int *addrs;
+	int all, status = 0;
+
+	all = (argc < 2);
+	if(all || strcmp(argv[1], "scale") == 0) {
+		addrs = (unsigned int *) malloc(sizeof(unsigned int) * BENCH_ACCESSES);
+		if(addrs == NULL) {
+			fprintf(stderr, "Could not allocate benchmark addresses.\n");
+			return(1);
+		}
+		benchScale(addrs);
+		free(addrs);
+	}
+	if(all || strcmp(argv[1], "probe") == 0) {
+		addrs = (unsigned int *) malloc(sizeof(unsigned int) * BENCH_ACCESSES);
+		if(addrs == NULL) {
+			fprintf(stderr, "Could not allocate benchmark addresses.\n");
+			return(1);
+		}
+		benchProbe(addrs);
+		free(addrs);
+	}
+	if(all || strcmp(argv[1], "parse") == 0) {
+		status |= benchParse(argc > 2 ? argv[2] : NULL);
+	}
+	if(!all && strcmp(argv[1], "suite") == 0) {
+		status |= benchSuite(argc - 1, argv + 1);
+	}
+
+	return(status);
+}
+
+/* END OF FILE */
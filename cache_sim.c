@@ -10,135 +10,215 @@
 
 /* Libraries */
 #include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <time.h>
 #include <ctype.h>
+#include <unistd.h>
 #include "cache_sim.h"
+#include "checkpoint.h"
+#include "hashmap.h"
+#include "hierarchy.h"
+#include "multicore.h"
+#include "output.h"
+#include "policy.h"
+#include "sample.h"
+#include "shadow.h"
+#include "shard.h"
+#include "stackdist.h"
+#include "sweep.h"
+#include "trace.h"
+
+/* Tags compared at once by the way search: 8 with AVX2, 4 with SSE2,
+ * else 1. Build with -DCACHE_SIM_NO_SIMD to force the scalar loop. */
+#if defined(__AVX2__) && !defined(CACHE_SIM_NO_SIMD)
+#include <immintrin.h>
+#define CACHE_PROBE_LANES	8
+#define CACHE_PROBE_WIDE_LANES	4
+#elif defined(__SSE2__) && !defined(CACHE_SIM_NO_SIMD)
+#include <emmintrin.h>
+#define CACHE_PROBE_LANES	4
+#define CACHE_PROBE_WIDE_LANES	2
+#else
+#define CACHE_PROBE_LANES	1
+#define CACHE_PROBE_WIDE_LANES	1
+#endif
+
+/* Numbers at the start of a saved cache: mm_size, cache_size,
+ * block_size, nSA, rep_policy, hits, misses, reads, writes, and the
+ * three miss classes */
+#define CACHE_SAVE_FIELDS	12
 
 /* Structs */
 
-/* Block
- *
- * Holds an integer that states if the bit is dirty or not,
- * an integer that states the validity of the bit, the tag
- * being held, and the data being held.
- *
- * @param dirty				0 = Clean, 1 = Dirty
- * @param valid				0 = Invalid, 1 = Valid
- * @param tag				Tag being held
- * @param data				Main memory block referenced
- */
-
-struct Block_ {
-	int access_count;
-	int time_count;
-	int dirty;
-	int valid;
-	char *tag;
-	int data;
-};
-
 /* Cache
  *
  * Cache object that holds all the data about cache access as well as 
- * the write policy, sizes, and an array of blocks.
+ * the write policy, sizes, and the state of every block. Block state
+ * is kept in flat arrays indexed by block # (set * nSA + way), so the
+ * ways of one set sit next to each other in memory.
  *
  * @param	hits			# of cache accesses that hit valid data
  * @param	misses			# of cache accesses that missed valid data
  * @param	reads			# of reads from main memory
  * @param	writes			# of writes from main memory
+ * @param	classes			# of misses of each class, when classifying
  * @param	cache_size		Total size of the cache in bytes
  * @param	block_size		How big each block of data should be
  * @param	block_count		Total number of blocks
- * @param	rep_policy		1 = LRU, 2 = FIFO
- * @param	blocks			The actual array of blocks  
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	addr_size		Bits for address, offset, index, and tag
+ * @param	decode_shift	1 if block_size and set_count are powers of 2
+ * @param	set_mask		set_count - 1, used when decode_shift is set
+ * @param	tags			Tag held by each block, when every tag fits in
+ *							32 bits, else NULL
+ * @param	wide_tags		Tag held by each block, when tags need more
+ *							than 32 bits, else NULL
+ * @param	policy			Replacement metadata of every set
+ * @param	valid			Bitmask, 1 = Valid
+ * @param	dirty			Bitmask, 1 = Dirty
+ * @param	evicted			1 if the last access or fill evicted a valid block
+ * @param	evict_address	First address of the evicted block
+ * @param	evict_dirty		1 if the evicted block was dirty
+ * @param	shadow			Fully associative shadow cache, or NULL when
+ *							misses are not classified
+ * @param	set_classes		# of misses of each class in each set
+ * @param	profile			Detailed statistics, or NULL when turned off
  */
 
 struct Cache_ {
 	
-	int hits;
-	int misses;
-	int reads;
-	int writes;
-
-	int mm_size;
-	int cache_size;
+	long long hits;
+	long long misses;
+	long long reads;
+	long long writes;
+	long long classes[3];
+
+	long long mm_size;
+	long long cache_size;
 	int block_size;
 	int block_count;
 	int set_count;
 	int nSA;
 	int rep_policy;
-	int addr_count;
 	int addr_size[5];
-	Block *block;
-	Memory *memory;
+	int decode_shift;
+	unsigned int set_mask;
+	unsigned int *tags;
+	unsigned long long *wide_tags;
+	Policy policy;
+	unsigned long long *valid;
+	unsigned long long *dirty;
+	int evicted;
+	unsigned long long evict_address;
+	int evict_dirty;
+	Shadow shadow;
+	long long *set_classes;
+	Profile profile;
 };
 
+/* Memory
+ *
+ * Record of one memory access from the trace, filled in as the trace
+ * is streamed through the cache.
+ *
+ * @param	mode			R = Read, W = Write
+ * @param	address			Main memory address
+ * @param	cache_block_max	Last cache block # of the set
+ * @param	cache_block_min	First cache block # of the set
+ * @param	cache_set		Cache set #
+ * @param	mm_block		Main memory block #
+ * @param	hit				1 = Hit, 0 = Miss
+ */
+
 struct Memory_ {
 	char mode;
-	int address;
+	unsigned long long address;
 	int cache_block_max;
 	int cache_block_min;
 	int cache_set;
-	int mm_block;
+	unsigned long long mm_block;
 	int hit;
 };
 
+/* bitTest, bitSet, bitClear
+ *
+ * Read and update one bit of a bitmask stored as an array of
+ * 64 bit words.
+ *
+ * @param	bits			Bitmask
+ * @param	i				Bit # to use
+ */
+
+static inline int bitTest(const unsigned long long *bits, int i) {
+	return((int)((bits[i >> 6] >> (i & 63)) & 1));
+}
+
+static inline void bitSet(unsigned long long *bits, int i) {
+	bits[i >> 6] |= 1ull << (i & 63);
+}
+
+static inline void bitClear(unsigned long long *bits, int i) {
+	bits[i >> 6] &= ~(1ull << (i & 63));
+}
+
 /* btoi
  *
- * Converts a binary string to an integer. Returns 0 on error.
+ * Converts a binary string to an unsigned integer. Returns 0 on error.
  *
  * @param	bin				Binary string to convert
  *
  * @result	dec				Decimal integer
  */
 
-int btoi(char *bin) {
-	int i, j, m, n;
-    int len, dec;
+unsigned long long btoi(char *bin) {
+	unsigned long long dec = 0;
+	int i, n;
 
-	dec = 0;
-	len = strlen(bin) - 1;
-
-	for(i = 0; i <= len; i++) {
-		n = (bin[i] - '0'); 
-        if((n > 1) || (n < 0)) {
+	for(i = 0; bin[i] != '\0'; i++) {
+		n = (bin[i] - '0');
+		if((n > 1) || (n < 0)) {
 			return 0;
 		}
-        for(j = 1, m = len; m > i; m--) {
-			j *= 2;
-		}
-		dec = dec + n * j;
+		dec = (dec << 1) | n;
 	}
 
 	return(dec);
 }
 
-/* itob
+/* tagPrint
  *
- * Converts an unsigned integer into a string containing its
- * 32 bit long binary representation.
+ * Prints a tag as a binary string of addr_size[3] bits without
+ * allocating any memory.
  *
- * @param	dec				Decimal integer to convert
+ * @param	cache			Cache the tag belongs to
+ * @param	tag				Tag to print
  *
- * @result	bin				Binary string
+ * @return	void
  */
 
-char *itob(unsigned int dec) {
-	char *bin;
-	int i;
-
-	bin = (char *) malloc(sizeof(char) * 33);
-	assert(bin != NULL);
-	bin[32] = '\0';
-
-	for(i = 0; i < 32; i++) {
-        bin[32 - 1 - i] = (dec == ((1 << i) | dec)) ? '1' : '0';
-    }
+static void tagPrint(Cache cache, unsigned long long tag) {
+	char bin[65];
+	int i, len;
 
-    return(bin);
+	len = cache->addr_size[3];
+	if(len < 0) {
+		len = 0;
+	}
+	else if(len > 64) {
+		len = 64;
+	}
+	for(i = 0; i < len; i++) {
+		bin[len - 1 - i] = ((tag >> i) & 1) ? '1' : '0';
+	}
+	bin[len] = '\0';
+	printf("%s", bin);
 }
 
 /* ceil_log2
@@ -173,284 +253,3088 @@ int ceil_log2(unsigned long long x) {
 
 	return(y);
 }
- 
-int main(int argc, char **argv) {
-	int goAgain = 1;
 
-	do {
-	Cache cache;
-	FILE *file;
+/* screenClear
+ *
+ * Clears the terminal with an escape sequence instead of running
+ * clear in a shell. Does nothing when stdout is not a terminal.
+ *
+ * @return	void
+ */
 
-	int addr_count, i, j, k, n, valid;
-	int mm_size = 0, cache_size = 0, block_size = 0, nSA = 0, rep_policy = 0;
-	int hits = 0;
-	double rate;
-	char addr[64], input[128], line[128];
-	char *filename = "N/A";
+static void screenClear(void) {
+	if(isatty(STDOUT_FILENO)) {
+		printf("\033[H\033[2J");
+	}
+}
+
+#ifndef CACHE_SIM_NO_MAIN
+#define OPTION_LIST_MAX	64
+
+/* Accesses read from a streamed trace at a time, so that reading and
+ * simulating can be timed apart */
+#define RUN_CHUNK		65536
+
+/* sample_warm value that warms the cache with every access */
+#define SAMPLE_WARM_ALL	(-1)
+
+/* OptionList
+ *
+ * Values of an option that can be swept. Holds one value unless the
+ * option was given as a comma separated list.
+ *
+ * @param	count			Number of values
+ * @param	values			The values
+ */
+
+struct OptionList_ {
+	int count;
+	long long values[OPTION_LIST_MAX];
+};
+
+/* Options
+ *
+ * Everything needed to run one simulation or a sweep, whether it came
+ * from the prompts, the command line, or a config file.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	filename		Name of the trace file
+ * @param	threads			Number of threads for a sweep, multicore run,
+ *							or cache
+ * @param	mrc				1 = Print the LRU miss ratio curve instead
+ * @param	opt_bound		1 = Print the OPT hit rate of the same cache
+ * @param	classify		1 = Sort misses into compulsory, capacity, and conflict
+ * @param	level_count		Number of levels of a hierarchy, 0 for one cache
+ * @param	levels			Cache size, block size, nSA, and policy of each level
+ * @param	inclusion		Inclusion policy of a hierarchy
+ * @param	cores			Number of cores of a multicore run, 0 for none
+ * @param	print_memory	1 = Print every memory access
+ * @param	print_cache		1 = Print the final status of the cache
+ * @param	print_tags		1 = Print the tag of every access
+ * @param	output			One of the OUTPUT_ formats
+ * @param	log				File for a CSV or binary log, NULL for stdout
+ * @param	stats			File for JSON statistics, NULL for none
+ * @param	sample_unit		Accesses simulated in detail per sample period
+ * @param	sample_period	Accesses per sample period, 0 for a full run
+ * @param	sample_warm		Accesses warmed before each unit, 0 for
+ *							SAMPLE_WARM_BLOCKS times the cache's blocks,
+ *							SAMPLE_WARM_ALL for every access
+ * @param	sample_error	Relative error target in percent, 0 for
+ *							SAMPLE_ERROR
+ * @param	checkpoint		File to save the cache to, NULL for none
+ * @param	checkpoint_at	# of accesses after which the cache is saved
+ * @param	restore			Checkpoint to resume from, NULL to start cold
+ * @param	warmup			# of accesses that only warm the cache
+ * @param	roi				1 = Count only between the trace's markers
+ */
+
+struct Options_ {
+	long long mm_size;
+	struct OptionList_ cache_size;
+	struct OptionList_ block_size;
+	struct OptionList_ nSA;
+	struct OptionList_ rep_policy;
+	char *filename;
+	int threads;
+	int mrc;
+	int opt_bound;
+	int classify;
+	int level_count;
+	long long levels[HIER_LEVELS_MAX][4];
+	int inclusion;
+	int cores;
+	int print_memory;
+	int print_cache;
+	int print_tags;
+	int output;
+	char *log;
+	char *stats;
+	long long sample_unit;
+	long long sample_period;
+	long long sample_warm;
+	double sample_error;
+	char *checkpoint;
+	long long checkpoint_at;
+	char *restore;
+	long long warmup;
+	int roi;
+};
+
+/* optionListSet
+ *
+ * Sets an option list to a single value.
+ *
+ * @param	list			Option list to set
+ * @param	value			The value
+ *
+ * @return	void
+ */
+
+static void optionListSet(struct OptionList_ *list, long long value) {
+	list->count = 1;
+	list->values[0] = value;
+}
+
+/* parsePolicy
+ *
+ * Converts a replacement policy name to its number.
+ *
+ * @param	name			A policy name, or its first letter, in any case
+ *
+ * @return	success			One of the CACHE_ policy numbers
+ * @return	failure			0
+ */
+
+static int parsePolicy(const char *name) {
+	if(strcasecmp(name, "L") == 0 || strcasecmp(name, "LRU") == 0) {
+		return(CACHE_LRU);
+	}
+	if(strcasecmp(name, "F") == 0 || strcasecmp(name, "FIFO") == 0) {
+		return(CACHE_FIFO);
+	}
+	if(strcasecmp(name, "O") == 0 || strcasecmp(name, "OPT") == 0) {
+		return(CACHE_OPT);
+	}
+	if(strcasecmp(name, "R") == 0 || strcasecmp(name, "Random") == 0) {
+		return(CACHE_RANDOM);
+	}
+	if(strcasecmp(name, "P") == 0 || strcasecmp(name, "PLRU") == 0) {
+		return(CACHE_PLRU);
+	}
+	if(strcasecmp(name, "LFU") == 0) {
+		return(CACHE_LFU);
+	}
+	if(strcasecmp(name, "S") == 0 || strcasecmp(name, "SRRIP") == 0) {
+		return(CACHE_SRRIP);
+	}
+	if(strcasecmp(name, "B") == 0 || strcasecmp(name, "BRRIP") == 0) {
+		return(CACHE_BRRIP);
+	}
+
+	return(0);
+}
+
+/* parseSize
+ *
+ * Converts a whole positive number of at most max.
+ *
+ * @param	text			Text to convert
+ * @param	max				Largest value allowed
+ * @param	value			Set to the number on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseSize(const char *text, long long max, long long *value) {
+	char *end;
+	long long n;
+
+	errno = 0;
+	n = strtoll(text, &end, 0);
+	if(errno != 0 || end == text || *end != '\0' || n <= 0 || n > max) {
+		return(0);
+	}
+	*value = n;
+
+	return(1);
+}
+
+/* parseCount
+ *
+ * Converts a whole positive number that fits in an int.
+ *
+ * @param	text			Text to convert
+ * @param	value			Set to the number on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseCount(const char *text, int *value) {
+	long long n;
+
+	if(!parseSize(text, INT_MAX, &n)) {
+		return(0);
+	}
+	*value = (int)n;
+
+	return(1);
+}
+
+/* parseList
+ *
+ * Converts a comma separated list of sizes or policy names.
+ *
+ * @param	text			Text to convert
+ * @param	list			Set to the values on success
+ * @param	policy			1 = Values are policy names, 0 = Sizes
+ * @param	max				Largest size allowed
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseList(const char *text, struct OptionList_ *list, int policy, long long max) {
+	char item[64];
+	const char *comma;
+	size_t len;
+	int count = 0;
 
-	/* Validate Inputs */
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
-	mm_size = getUserInt("\nEnter the size of the main memory in bytes: ", 32000, 4);
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
-	cache_size = getUserInt("\nEnter the size of the cache in bytes: ", mm_size, 2);
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
-	block_size = getUserInt("\nEnter the cache block/line size: ", cache_size, 2);
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
-	nSA = getUserInt("\nEnter the degrees of set-associativity: ", block_size, 1);
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
 	do {
-		printf("\nEnter the replacement policy (L/F): ");
-		fgets(input, sizeof(input), stdin);
-		for(i = 0; i < sizeof(input); i++) {
-			if(input[i] == '\n') {
-				input[i] = '\0';
-			}
+		comma = strchr(text, ',');
+		len = (comma == NULL) ? strlen(text) : (size_t)(comma - text);
+		if(len == 0 || len >= sizeof(item) || count == OPTION_LIST_MAX) {
+			return(0);
 		}
-		valid = 0;
-		if(input[0] == 'L') {
-			rep_policy = 1;
-			valid = 1;
+		memcpy(item, text, len);
+		item[len] = '\0';
+		if(policy) {
+			list->values[count] = parsePolicy(item);
+			if(list->values[count] == 0) {
+				return(0);
+			}
 		}
-		else if(input[0] == 'F') {
-			rep_policy = 2;
-			valid = 1;
+		else if(!parseSize(item, max, &list->values[count])) {
+			return(0);
 		}
-	} while(!valid);
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
-	do {
-		printf("\nEnter the name of the input file: ");
-		fgets(input, sizeof(input), stdin);
-		for(i = 0; i < sizeof(input); i++) {
-			if(input[i] == '\n') {
-				input[i] = '\0';
-			}
+		count++;
+		text = comma + 1;
+	} while(comma != NULL);
+	list->count = count;
+
+	return(1);
+}
+
+/* parseLevel
+ *
+ * Converts one level of a hierarchy, given as size:block:assoc:policy,
+ * and adds it to the options.
+ *
+ * @param	text			Text to convert, such as 32768:64:8:L
+ * @param	options			Options to add the level to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseLevel(const char *text, struct Options_ *options) {
+	char item[64], *field[4], *colon;
+	long long *level;
+	int i;
+
+	if(options->level_count == HIER_LEVELS_MAX || strlen(text) >= sizeof(item)) {
+		return(0);
+	}
+	strcpy(item, text);
+	field[0] = item;
+	for(i = 1; i < 4; i++) {
+		colon = strchr(field[i - 1], ':');
+		if(colon == NULL) {
+			return(0);
 		}
-		valid = 1;
-		filename = input;
-		file = fopen(filename, "r");
-		if(file == NULL) {
-			printf("\nError: Could not open file %s", filename);
-			valid = 0;
+		*colon = '\0';
+		field[i] = colon + 1;
+	}
+
+	level = options->levels[options->level_count];
+	for(i = 0; i < 3; i++) {
+		if(!parseSize(field[i], (i == 0) ? LLONG_MAX : INT_MAX, &level[i])) {
+			return(0);
 		}
-	} while(!valid);
+	}
+	level[3] = parsePolicy(field[3]);
+	if(level[3] == 0) {
+		return(0);
+	}
+	options->level_count++;
 
-	/* Print out final input status */
-	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	return(1);
+}
+
+/* parseSample
+ *
+ * Converts the unit and period of a sampled run, given as unit:period,
+ * and adds them to the options.
+ *
+ * @param	text			Text to convert, such as 1000:100000
+ * @param	options			Options to add the sampling to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseSample(const char *text, struct Options_ *options) {
+	char item[64], *colon;
+
+	if(strlen(text) >= sizeof(item)) {
+		return(0);
+	}
+	strcpy(item, text);
+	colon = strchr(item, ':');
+	if(colon == NULL) {
+		return(0);
+	}
+	*colon = '\0';
+
+	return(parseSize(item, LLONG_MAX, &options->sample_unit)
+		&& parseSize(colon + 1, LLONG_MAX, &options->sample_period));
+}
+
+/* parseWarm
+ *
+ * Converts the warm window of a sampled run: a number of accesses, or
+ * "all" to warm the cache with every access.
+ *
+ * @param	text			Text to convert, such as 20000 or all
+ * @param	value			Set to the window on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseWarm(const char *text, long long *value) {
+	if(strcmp(text, "all") == 0) {
+		*value = SAMPLE_WARM_ALL;
+		return(1);
+	}
+
+	return(parseSize(text, LLONG_MAX, value));
+}
+
+/* parsePercent
+ *
+ * Converts a percentage above 0 and below 100.
+ *
+ * @param	text			Text to convert, such as 2.5
+ * @param	value			Set to the percentage on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parsePercent(const char *text, double *value) {
+	char *end;
+	double n;
+
+	errno = 0;
+	n = strtod(text, &end);
+	if(errno != 0 || end == text || *end != '\0' || !(n > 0 && n < 100)) {
+		return(0);
+	}
+	*value = n;
+
+	return(1);
+}
+
+/* parseOutput
+ *
+ * Converts an output format name to its number.
+ *
+ * @param	name			none, summary, csv, or binary in any case
+ * @param	output			Set to the format on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseOutput(const char *name, int *output) {
+	if(strcasecmp(name, "none") == 0) {
+		*output = OUTPUT_NONE;
+	}
+	else if(strcasecmp(name, "summary") == 0) {
+		*output = OUTPUT_SUMMARY;
+	}
+	else if(strcasecmp(name, "csv") == 0) {
+		*output = OUTPUT_CSV;
+	}
+	else if(strcasecmp(name, "binary") == 0) {
+		*output = OUTPUT_BINARY;
+	}
+	else {
+		return(0);
+	}
+
+	return(1);
+}
+
+/* parseInclusion
+ *
+ * Converts an inclusion policy name to its number.
+ *
+ * @param	name			nine, inclusive, or exclusive in any case
+ * @param	inclusion		Set to the policy on success
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int parseInclusion(const char *name, int *inclusion) {
+	if(strcasecmp(name, "nine") == 0) {
+		*inclusion = HIER_NINE;
+	}
+	else if(strcasecmp(name, "inclusive") == 0) {
+		*inclusion = HIER_INCLUSIVE;
+	}
+	else if(strcasecmp(name, "exclusive") == 0) {
+		*inclusion = HIER_EXCLUSIVE;
+	}
+	else {
+		return(0);
+	}
+
+	return(1);
+}
+
+/* optionSet
+ *
+ * Sets one option by its long name. Shared by the command line and
+ * config files so both accept the same names. Sizes, assoc, and
+ * policy take a comma separated list of values to sweep.
+ *
+ * @param	options			Options to update
+ * @param	name			Long option name, such as cache-size
+ * @param	value			Value of the option
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int optionSet(struct Options_ *options, const char *name, const char *value) {
+	if(strcmp(name, "mm-size") == 0) {
+		return(parseSize(value, LLONG_MAX, &options->mm_size));
+	}
+	if(strcmp(name, "cache-size") == 0) {
+		return(parseList(value, &options->cache_size, 0, LLONG_MAX));
+	}
+	if(strcmp(name, "block-size") == 0) {
+		return(parseList(value, &options->block_size, 0, INT_MAX));
+	}
+	if(strcmp(name, "assoc") == 0) {
+		return(parseList(value, &options->nSA, 0, INT_MAX));
+	}
+	if(strcmp(name, "policy") == 0) {
+		return(parseList(value, &options->rep_policy, 1, 0));
+	}
+	if(strcmp(name, "threads") == 0) {
+		return(parseCount(value, &options->threads));
+	}
+	if(strcmp(name, "level") == 0) {
+		return(parseLevel(value, options));
+	}
+	if(strcmp(name, "inclusion") == 0) {
+		return(parseInclusion(value, &options->inclusion));
+	}
+	if(strcmp(name, "cores") == 0) {
+		return(parseCount(value, &options->cores) && options->cores <= MULTICORE_MAX);
+	}
+	if(strcmp(name, "trace") == 0) {
+		free(options->filename);
+		options->filename = strdup(value);
+		return(options->filename != NULL);
+	}
+	if(strcmp(name, "output") == 0) {
+		return(parseOutput(value, &options->output));
+	}
+	if(strcmp(name, "log") == 0) {
+		free(options->log);
+		options->log = strdup(value);
+		return(options->log != NULL);
+	}
+	if(strcmp(name, "stats") == 0) {
+		free(options->stats);
+		options->stats = strdup(value);
+		return(options->stats != NULL);
+	}
+	if(strcmp(name, "sample") == 0) {
+		return(parseSample(value, options));
+	}
+	if(strcmp(name, "sample-warm") == 0) {
+		return(parseWarm(value, &options->sample_warm));
+	}
+	if(strcmp(name, "sample-error") == 0) {
+		return(parsePercent(value, &options->sample_error));
+	}
+	if(strcmp(name, "checkpoint") == 0) {
+		free(options->checkpoint);
+		options->checkpoint = strdup(value);
+		return(options->checkpoint != NULL);
+	}
+	if(strcmp(name, "checkpoint-at") == 0) {
+		return(parseSize(value, LLONG_MAX, &options->checkpoint_at));
+	}
+	if(strcmp(name, "warmup") == 0) {
+		return(parseSize(value, LLONG_MAX, &options->warmup));
+	}
+	if(strcmp(name, "restore") == 0) {
+		free(options->restore);
+		options->restore = strdup(value);
+		return(options->restore != NULL);
+	}
+
+	return(0);
+}
+
+/* optionsLoad
+ *
+ * Reads options from a config file of "name = value" lines, using the
+ * long option names. Blank lines and lines starting with # are skipped.
+ *
+ * @param	options			Options to update
+ * @param	filename		Name of the config file
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int optionsLoad(struct Options_ *options, const char *filename) {
+	FILE *file;
+	char line[1024], *name, *value, *end;
+	int line_no = 0, ok = 1;
+
+	file = fopen(filename, "r");
+	if(file == NULL) {
+		fprintf(stderr, "Error: Could not open config file %s\n", filename);
+		return(0);
+	}
+
+	while(ok && fgets(line, sizeof(line), file) != NULL) {
+		line_no++;
+		name = line;
+		while(isspace((unsigned char)*name)) {
+			name++;
+		}
+		if(*name == '\0' || *name == '#') {
+			continue;
+		}
+
+		value = strchr(name, '=');
+		if(value == NULL) {
+			fprintf(stderr, "Error: %s:%d: expected name = value\n", filename, line_no);
+			ok = 0;
+			break;
+		}
+		for(end = value; end > name && isspace((unsigned char)end[-1]); end--);
+		*end = '\0';
+		for(value++; isspace((unsigned char)*value); value++);
+		for(end = value + strlen(value); end > value && isspace((unsigned char)end[-1]); end--);
+		*end = '\0';
+
+		if(!optionSet(options, name, value)) {
+			fprintf(stderr, "Error: %s:%d: bad value for %s\n", filename, line_no, name);
+			ok = 0;
+		}
+	}
+	fclose(file);
+
+	return(ok);
+}
+
+/* optionsSweep
+ *
+ * Tells whether the options ask for more than one configuration.
+ *
+ * @param	options			Options to check
+ *
+ * @return	sweep			1
+ * @return	single run		0
+ */
+
+static int optionsSweep(struct Options_ *options) {
+	return(options->cache_size.count > 1 || options->block_size.count > 1
+		|| options->nSA.count > 1 || options->rep_policy.count > 1);
+}
+
+/* pointCheck
+ *
+ * Makes sure one cache configuration can be built, and says why not.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ *
+ * @return	valid			NULL
+ * @return	invalid			Reason the configuration is invalid
+ */
+
+static const char *pointCheck(long long mm_size, long long cache_size, int block_size, int nSA) {
+	CacheConfig config = {0};
+
+	config.mm_size = mm_size;
+	config.cache_size = cache_size;
+	config.block_size = block_size;
+	config.nSA = nSA;
+	config.rep_policy = CACHE_LRU;
+
+	return(cacheConfigCheck(&config));
+}
+
+/* optionsCheck
+ *
+ * Makes sure every required option was given. For a single run the
+ * cache must also be buildable. Sweeps skip bad points later instead.
+ *
+ * @param	options			Options to check
+ *
+ * @return	valid			1
+ * @return	invalid			0
+ */
+
+static int optionsCheck(struct Options_ *options) {
+	const char *reason;
+	int i;
+
+	if(options->output != OUTPUT_SUMMARY && (options->cores > 0 || options->level_count > 0
+		|| options->mrc || optionsSweep(options))) {
+		fprintf(stderr, "Error: output formats only apply to a single cache\n");
+		return(0);
+	}
+	if(options->log != NULL && options->output != OUTPUT_CSV && options->output != OUTPUT_BINARY) {
+		fprintf(stderr, "Error: log needs csv or binary output\n");
+		return(0);
+	}
+	if(options->stats != NULL && (options->cores > 0 || options->level_count > 0
+		|| options->mrc || optionsSweep(options))) {
+		fprintf(stderr, "Error: stats only apply to a single cache\n");
+		return(0);
+	}
+	if(options->stats != NULL && strcmp(options->stats, "-") == 0
+		&& (options->output == OUTPUT_CSV || options->output == OUTPUT_BINARY)
+		&& (options->log == NULL || strcmp(options->log, "-") == 0)) {
+		fprintf(stderr, "Error: stats and log cannot both go to stdout\n");
+		return(0);
+	}
+	if(options->sample_period > 0 && (options->cores > 0 || options->level_count > 0
+		|| options->mrc || optionsSweep(options))) {
+		fprintf(stderr, "Error: sample only applies to a single cache\n");
+		return(0);
+	}
+	if(options->sample_period > 0 && (options->opt_bound || options->classify
+		|| options->print_memory || options->stats != NULL
+		|| options->output == OUTPUT_CSV || options->output == OUTPUT_BINARY)) {
+		fprintf(stderr, "Error: sample cannot be used with opt-bound, classify, verbose, stats, or a log\n");
+		return(0);
+	}
+	if(options->sample_period == 0 && (options->sample_warm != 0 || options->sample_error > 0)) {
+		fprintf(stderr, "Error: sample-warm and sample-error need sample\n");
+		return(0);
+	}
+	if(options->sample_unit > options->sample_period) {
+		fprintf(stderr, "Error: sample unit must not be longer than its period\n");
+		return(0);
+	}
+	if((options->checkpoint != NULL) != (options->checkpoint_at > 0)) {
+		fprintf(stderr, "Error: checkpoint and checkpoint-at go together\n");
+		return(0);
+	}
+	if(options->checkpoint != NULL && (options->cores > 0 || options->level_count > 0
+		|| options->mrc || optionsSweep(options))) {
+		fprintf(stderr, "Error: checkpoint only applies to a single cache\n");
+		return(0);
+	}
+	if(options->restore != NULL && (options->cores > 0 || options->level_count > 0
+		|| options->mrc)) {
+		fprintf(stderr, "Error: restore only applies to a single cache or a sweep\n");
+		return(0);
+	}
+	if((options->checkpoint != NULL || options->restore != NULL) && (options->sample_period > 0
+		|| options->opt_bound || options->classify || options->stats != NULL)) {
+		fprintf(stderr, "Error: checkpoint and restore cannot be used with sample, opt-bound, classify, or stats\n");
+		return(0);
+	}
+	if((options->warmup > 0 || options->roi) && (options->cores > 0 || options->level_count > 0
+		|| options->mrc || optionsSweep(options))) {
+		fprintf(stderr, "Error: warmup and roi only apply to a single cache\n");
+		return(0);
+	}
+	if((options->warmup > 0 || options->roi) && (options->sample_period > 0 || options->opt_bound
+		|| options->classify || options->print_memory || options->checkpoint != NULL
+		|| options->restore != NULL)) {
+		fprintf(stderr, "Error: warmup and roi cannot be used with sample, opt-bound, classify, verbose, checkpoint, or restore\n");
+		return(0);
+	}
+	if(options->cores > 0 && (options->level_count < 1 || options->level_count > 2)) {
+		fprintf(stderr, "Error: cores needs a private level and at most one shared level\n");
+		return(0);
+	}
+	if(options->level_count > 0) {
+		if(options->mm_size < 4 || options->filename == NULL) {
+			fprintf(stderr, "Error: mm-size and trace are required\n");
+			return(0);
+		}
+		for(i = 0; i < options->level_count; i++) {
+			reason = pointCheck(options->mm_size, options->levels[i][0],
+				(int)options->levels[i][1], (int)options->levels[i][2]);
+			if(reason != NULL) {
+				fprintf(stderr, "Error: level %d: %s\n", i + 1, reason);
+				return(0);
+			}
+		}
+		return(1);
+	}
+	if(options->mm_size < 4 || options->cache_size.count == 0 || options->block_size.count == 0
+		|| options->nSA.count == 0 || (options->rep_policy.count == 0 && !options->mrc)
+		|| options->filename == NULL) {
+		fprintf(stderr, "Error: mm-size, cache-size, block-size, assoc, policy, and trace are all required\n");
+		return(0);
+	}
+	if(options->sample_period > 0 && options->rep_policy.values[0] == CACHE_OPT) {
+		fprintf(stderr, "Error: sample cannot use OPT\n");
+		return(0);
+	}
+	if((options->warmup > 0 || options->roi) && options->rep_policy.values[0] == CACHE_OPT) {
+		fprintf(stderr, "Error: warmup and roi cannot use OPT\n");
+		return(0);
+	}
+	for(i = 0; i < options->rep_policy.count; i++) {
+		if((options->checkpoint != NULL || options->restore != NULL)
+			&& options->rep_policy.values[i] == CACHE_OPT) {
+			fprintf(stderr, "Error: checkpoint and restore cannot use OPT\n");
+			return(0);
+		}
+	}
+	if(!optionsSweep(options) || options->mrc) {
+		reason = pointCheck(options->mm_size, options->cache_size.values[0],
+			(int)options->block_size.values[0], (int)options->nSA.values[0]);
+		if(reason != NULL) {
+			fprintf(stderr, "Error: %s\n", reason);
+			return(0);
+		}
+	}
+
+	return(1);
+}
+
+/* runNow
+ *
+ * Reads the monotonic clock.
+ *
+ * @return	seconds			Current time in seconds
+ */
+
+static double runNow(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((double)ts.tv_sec + (double)ts.tv_nsec * 1e-9);
+}
+
+/* statsPhase
+ *
+ * Writes how fast one phase of a run went as a JSON member.
+ *
+ * @param	file			File to write to
+ * @param	name			Name of the phase
+ * @param	seconds			Time the phase took
+ * @param	accesses		Number of accesses in the run
+ * @param	last			1 if no member follows
+ *
+ * @return	void
+ */
+
+static void statsPhase(FILE *file, const char *name, double seconds, long accesses, int last) {
+	fprintf(file, "\t\t\"%s\": {\"seconds\": %.6f, \"accesses_per_second\": %.0f, \"ns_per_access\": %.3f}%s\n",
+		name, seconds, (seconds > 0) ? (double)accesses / seconds : 0.0,
+		(accesses > 0) ? seconds * 1e9 / (double)accesses : 0.0, last ? "" : ",");
+}
+
+/* statsWrite
+ *
+ * Writes the statistics of a finished run as one JSON object: the
+ * cache, the totals, the cache's profile, and how fast the run went.
+ * Reading the trace is the parse phase, running it through the cache
+ * is the simulate phase, and writing out the profile is the report
+ * phase.
+ *
+ * @param	path			File to write, - for stdout
+ * @param	cache			Cache that was simulated, with a profile
+ * @param	stats			Counters of the run
+ * @param	accesses		Number of accesses in the trace
+ * @param	parse_time		Seconds spent reading the trace
+ * @param	simulate_time	Seconds spent simulating
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int statsWrite(const char *path, Cache cache, const CacheStats *stats, long accesses,
+	double parse_time, double simulate_time) {
+	FILE *file;
+	double started, report_time;
+	int ok;
+
+	file = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+	if(file == NULL) {
+		return(0);
+	}
+
+	started = runNow();
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"config\": {\"mm_size\": %lld, \"cache_size\": %lld, \"block_size\": %d, \"assoc\": %d, \"sets\": %d, \"policy\": \"%s\"},\n",
+		cache->mm_size, cache->cache_size, cache->block_size, cache->nSA, cache->set_count,
+		cachePolicyName(cache->rep_policy));
+	fprintf(file, "\t\"totals\": {\"accesses\": %ld, \"hits\": %lld, \"misses\": %lld, \"memory_reads\": %lld, \"memory_writes\": %lld, \"hit_rate\": %f},\n",
+		accesses, stats->hits, stats->misses, stats->reads, stats->writes,
+		(accesses > 0) ? (double)stats->hits / (double)accesses : 0.0);
+	profileWrite(cache->profile, file);
+	report_time = runNow() - started;
+
+	fprintf(file, "\t\"throughput\": {\n");
+	statsPhase(file, "parse", parse_time, accesses, 0);
+	statsPhase(file, "simulate", simulate_time, accesses, 0);
+	statsPhase(file, "report", report_time, accesses, 0);
+	statsPhase(file, "total", parse_time + simulate_time + report_time, accesses, 1);
+	fprintf(file, "\t}\n}\n");
+
+	ok = !ferror(file);
+	if(file == stdout) {
+		ok = (fflush(file) == 0) && ok;
+	}
+	else {
+		ok = (fclose(file) == 0) && ok;
+	}
+
+	return(ok);
+}
+
+/* runTraceCheck
+ *
+ * Makes sure the trace was not cut short by an access past main
+ * memory, which no cache of the run can hold.
+ *
+ * @param	options			Options of the run
+ * @param	trace			Trace that was read
+ *
+ * @return	whole trace		1
+ * @return	cut short		0
+ */
+
+static int runTraceCheck(struct Options_ *options, Trace trace) {
+	unsigned long long address;
+
+	if(traceOverLimit(trace, &address)) {
+		fprintf(stderr, "Error: Address 0x%llx of the trace is past main memory of %lld bytes\n",
+			address, options->mm_size);
+		return(0);
+	}
+
+	return(1);
+}
+
+/* runSave
+ *
+ * Writes a checkpoint of a cache partway through a run.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	cache			Cache to save
+ * @param	position		# of trace accesses run so far, not counting
+ *							markers
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int runSave(const char *filename, Cache cache, long position) {
+	if(!checkpointWrite(filename, cache, (unsigned long long)position)) {
+		fprintf(stderr, "Error: Could not write checkpoint %s\n", filename);
+		return(0);
+	}
+
+	return(1);
+}
+
+/* runResume
+ *
+ * Opens a checkpoint and skips the accesses of the trace it has
+ * already seen, so the run can go on from it. Markers are skipped
+ * without being counted.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	trace			Opened trace, read up to the checkpoint
+ *
+ * @return	success			checkpoint
+ * @return	failure			NULL
+ */
+
+static Checkpoint runResume(const char *filename, Trace trace) {
+	Checkpoint checkpoint;
+	unsigned long long i, position, address;
+	char mode;
+
+	checkpoint = checkpointOpen(filename, 1);
+	if(checkpoint == NULL) {
+		fprintf(stderr, "Error: Could not read checkpoint %s\n", filename);
+		return NULL;
+	}
+
+	position = checkpointPosition(checkpoint);
+	for(i = 0; i < position && traceNext(trace, &mode, &address); ) {
+		if(mode != TRACE_BEGIN && mode != TRACE_END) {
+			i++;
+		}
+	}
+	if(i < position) {
+		if(!traceOverLimit(trace, &address)) {
+			fprintf(stderr, "Error: The trace ends before checkpoint %s was taken\n", filename);
+		}
+		checkpointClose(checkpoint);
+		return NULL;
+	}
+
+	return(checkpoint);
+}
+
+/* runSimulation
+ *
+ * Streams a trace through a new cache and prints the results. OPT, and
+ * the highest possible hit rate, need to know the future, so for those
+ * the trace is loaded into memory instead. With more than one thread,
+ * and nothing to print per access, the sets are split among threads.
+ * A log of every access or the statistics to stdout take the place of
+ * the summary. A run restored from a checkpoint keeps counting from
+ * the checkpoint's counters, so it prints what a run over the whole
+ * trace would. Accesses of the warm-up, or outside the region of
+ * interest, go through cacheWarm and are left out of every count.
+ *
+ * @param	options			What to simulate and what to print
+ * @param	trace			Opened trace to simulate
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int runSimulation(struct Options_ *options, Trace trace) {
+	Cache cache, opt;
+	Shards shards = NULL;
+	Output out = NULL;
+	Checkpoint checkpoint;
+	CacheStats stats;
+	struct Memory_ record;
+	unsigned long long *addresses = NULL;
+	char *modes = NULL;
+	unsigned long long *next_use = NULL;
+	long i, j, first, end, start = 0, count = 0, addr_count, position, warmed = 0;
+	long long n, hits = 0;
+	int loaded, set, logged, summary, status = 0, saved = 0, inside;
+	double rate, started, parse_time = 0, simulate_time = 0;
+
+	cache = cacheCreate(options->cache_size.values[0], (int)options->block_size.values[0],
+		(int)options->rep_policy.values[0]);
+	assert(cache != NULL);
+
+	cacheSetGeometry(cache, options->mm_size, (int)options->nSA.values[0]);
+	cacheSetClassify(cache, options->classify);
+	cacheSetProfile(cache, options->stats != NULL);
+
+	/* Pick up where a checkpoint left off */
+	if(options->restore != NULL) {
+		checkpoint = runResume(options->restore, trace);
+		if(checkpoint != NULL && !checkpointRestore(checkpoint, cache)) {
+			fprintf(stderr, "Error: Checkpoint %s does not match the cache\n", options->restore);
+			checkpointClose(checkpoint);
+			checkpoint = NULL;
+		}
+		if(checkpoint == NULL) {
+			cacheDestroy(cache);
+			return(1);
+		}
+		start = (long)checkpointPosition(checkpoint);
+		checkpointClose(checkpoint);
+	}
+
+	logged = (options->output == OUTPUT_CSV || options->output == OUTPUT_BINARY);
+	summary = ((options->output == OUTPUT_SUMMARY)
+		|| (logged && options->log != NULL && strcmp(options->log, "-") != 0))
+		&& (options->stats == NULL || strcmp(options->stats, "-") != 0);
+	if(logged) {
+		out = outputOpen(options->log, options->output);
+		if(out == NULL) {
+			fprintf(stderr, "Error: Could not open log %s\n", options->log);
+			cacheDestroy(cache);
+			return(1);
+		}
+	}
+
+	/* Split the sets among threads when nothing is printed per access
+	 * and nothing needs the whole cache at the end */
+	if(options->threads > 1 && !options->print_memory && !options->print_tags
+		&& !options->print_cache && !options->classify && !logged && options->stats == NULL
+		&& options->checkpoint == NULL && options->restore == NULL
+		&& options->warmup == 0 && !options->roi) {
+		shards = shardsCreate(options->mm_size, cache->cache_size, cache->block_size, cache->nSA,
+			cache->rep_policy, options->threads);
+	}
+
+	/* Find the next use of every access in one backward pass */
+	loaded = (cache->rep_policy == CACHE_OPT || options->opt_bound);
+	started = runNow();
+	if(loaded) {
+		count = traceLoad(trace, &addresses, &modes);
+		if(count >= 0) {
+			next_use = (unsigned long long *) malloc(sizeof(unsigned long long) * (count + 1));
+		}
+		if(next_use == NULL || !cacheNextUse(cache, addresses, modes, count, next_use)) {
+			fprintf(stderr, "Error: Not enough memory to load the trace\n");
+			free(addresses);
+			free(modes);
+			free(next_use);
+			outputClose(out);
+			shardsDestroy(shards);
+			cacheDestroy(cache);
+			return(1);
+		}
+	}
+	parse_time = runNow() - started;
+
+	if(summary) {
+		n = cache->cache_size + cache->addr_size[3] + 1 + 1;
+
+		printf("\nSimulator Output:");
+		printf("\nTotal address lines required = %d", cache->addr_size[0]);
+		printf("\nNumber of bits for offset = %d", cache->addr_size[1]);
+		printf("\nNumber of bits for index = %d", cache->addr_size[2]);
+		printf("\nNumber of bits for tag = %d", cache->addr_size[3]);
+		printf("\nTotal cache size required = %lld", n);
+	}
+
+	if(options->print_memory) {
+		memoryPrintHeader();
+	}
+
+	/* Run the trace through the shards, or through the cache one access
+	 * at a time */
+	addr_count = start;
+	position = start;
+	inside = !options->roi;
+	if(shards != NULL) {
+		i = shardsRun(shards, loaded ? NULL : trace, addresses, modes, next_use, count);
+		if(i < 0) {
+			fprintf(stderr, "Error: Could not start the shard threads\n");
+			free(addresses);
+			free(modes);
+			free(next_use);
+			shardsDestroy(shards);
+			cacheDestroy(cache);
+			return(1);
+		}
+		addr_count = i;
+	}
+	else {
+		if(!loaded) {
+			addresses = (unsigned long long *) malloc(sizeof(unsigned long long) * RUN_CHUNK);
+			modes = (char *) malloc(RUN_CHUNK);
+			assert(addresses != NULL && modes != NULL);
+		}
+		for(i = start; ; i = end) {
+			/* A loaded trace is one chunk, else read the next one */
+			if(loaded) {
+				first = 0;
+				end = count;
+			}
+			else {
+				started = runNow();
+				for(j = 0; j < RUN_CHUNK && traceNext(trace, &modes[j], &addresses[j]); j++);
+				parse_time += runNow() - started;
+				first = i;
+				end = i + j;
+			}
+			if(end == i) {
+				break;
+			}
+
+			started = runNow();
+			for(j = i; j < end; j++) {
+				record.mode = modes[j - first];
+				record.address = addresses[j - first];
+
+				/* Markers only open and close the region of interest, and
+				 * the accesses that are not counted only warm the cache */
+				if(record.mode == TRACE_BEGIN || record.mode == TRACE_END) {
+					inside = (record.mode == TRACE_BEGIN) || !options->roi;
+					continue;
+				}
+				if(position == options->checkpoint_at && options->checkpoint != NULL) {
+					status |= !runSave(options->checkpoint, cache, position);
+					saved = 1;
+				}
+				if(position < options->warmup || !inside) {
+					if(record.mode == 'R' || record.mode == 'W') {
+						cacheWarm(cache, record.address, record.mode == 'W');
+					}
+					warmed++;
+					position++;
+					continue;
+				}
+				record.mm_block = record.address / (unsigned int)cache->block_size;
+				record.cache_set = (int)(record.mm_block % (unsigned int)cache->set_count);
+				record.cache_block_min = record.cache_set * cache->nSA;
+				record.cache_block_max = record.cache_block_min + cache->nSA - 1;
+				if(record.mode == 'R' || record.mode == 'W') {
+					if(options->print_tags) {
+						printf("\n");
+						tagPrint(cache, record.mm_block / (unsigned int)cache->set_count);
+					}
+					record.hit = cacheAccessNext(cache, record.address, record.mode == 'W',
+						loaded ? next_use[j] : CACHE_NEVER);
+					if(out != NULL) {
+						outputAccess(out, (unsigned long long)position, record.mode == 'W', record.address,
+							record.mm_block, record.cache_set, record.hit);
+					}
+				}
+				else {
+					record.hit = 0;
+				}
+				addr_count++;
+				position++;
+
+				if(options->print_memory) {
+					memoryPrint(cache, &record);
+				}
+			}
+			simulate_time += runNow() - started;
+		}
+	}
+	if(!runTraceCheck(options, trace)) {
+		free(addresses);
+		free(modes);
+		free(next_use);
+		outputClose(out);
+		shardsDestroy(shards);
+		cacheDestroy(cache);
+		return(1);
+	}
+
+	if(options->checkpoint != NULL && !saved && position == options->checkpoint_at) {
+		status |= !runSave(options->checkpoint, cache, position);
+	}
+	else if(options->checkpoint != NULL && !saved) {
+		fprintf(stderr, "Error: No access %lld in the trace to checkpoint at\n",
+			options->checkpoint_at);
+		status = 1;
+	}
+
+	if(shards != NULL) {
+		shardsGetStats(shards, &stats);
+	}
+	else {
+		cacheGetStats(cache, &stats);
+	}
+	if(!outputClose(out)) {
+		fprintf(stderr, "Error: Could not write the log\n");
+		status = 1;
+	}
+	if(options->stats != NULL && !statsWrite(options->stats, cache, &stats, addr_count,
+		parse_time, simulate_time)) {
+		fprintf(stderr, "Error: Could not write the stats to %s\n", options->stats);
+		status = 1;
+	}
+
+	if(summary) {
+		/* The best any cache of this shape could do is what OPT does */
+		if(options->opt_bound) {
+			if(cache->rep_policy == CACHE_OPT) {
+				hits = stats.hits;
+			}
+			else {
+				opt = cacheCreate(cache->cache_size, cache->block_size, CACHE_OPT);
+				assert(opt != NULL);
+				cacheSetGeometry(opt, cache->mm_size, cache->nSA);
+				for(i = 0; i < count; i++) {
+					if(modes[i] == 'R' || modes[i] == 'W') {
+						hits += cacheAccessNext(opt, addresses[i], modes[i] == 'W', next_use[i]);
+					}
+				}
+				cacheDestroy(opt);
+			}
+			rate = (addr_count > 0) ? ((double)hits / (double)addr_count) * 100 : 0;
+			printf("\n\nHighest possible hit rate = %lld/%ld = %f%%", hits, addr_count, rate);
+		}
+		else {
+			printf("\n");
+		}
+		rate = (addr_count > 0) ? ((double)stats.hits / (double)addr_count) * 100 : 0;
+		if(options->warmup > 0 || options->roi) {
+			printf("\nAccesses warmed but not counted = %ld", warmed);
+		}
+		printf("\nActual hit rate = %lld/%ld = %f%%", stats.hits, addr_count, rate);
+
+		if(options->classify) {
+			printf("\n\nCompulsory misses = %lld", cache->classes[CACHE_COMPULSORY]);
+			printf("\nCapacity misses = %lld", cache->classes[CACHE_CAPACITY]);
+			printf("\nConflict misses = %lld", cache->classes[CACHE_CONFLICT]);
+			printf("\n\nMisses by set:\nSet\tCompulsory\tCapacity\tConflict");
+			for(set = 0; set < cache->set_count; set++) {
+				printf("\n%d\t%lld\t%lld\t%lld", set, cacheGetSetMisses(cache, set, CACHE_COMPULSORY),
+					cacheGetSetMisses(cache, set, CACHE_CAPACITY),
+					cacheGetSetMisses(cache, set, CACHE_CONFLICT));
+			}
+		}
+	}
+
+	if(options->print_cache) {
+		printf("\n\nFinal status of the cache:");
+		cachePrint(cache);
+	}
+	if(summary || options->print_cache) {
+		printf("\n");
+	}
+
+	free(addresses);
+	free(modes);
+	free(next_use);
+	shardsDestroy(shards);
+	cacheDestroy(cache);
+	return(status);
+}
+
+/* runSampled
+ *
+ * Runs one cache over the trace in sampled mode and prints the
+ * estimated hit rate, its confidence interval, and whether the error
+ * target was met. If it was not, suggests a period that would meet it.
+ *
+ * @param	options			Options of the run
+ * @param	trace			Opened trace
+ *
+ * @return	success			0
+ */
+
+static int runSampled(struct Options_ *options, Trace trace) {
+	Cache cache;
+	Sampler sampler;
+	SampleStats stats;
+	unsigned long long address;
+	long long warm;
+	double target;
+	char mode;
+
+	cache = cacheCreate(options->cache_size.values[0], (int)options->block_size.values[0],
+		(int)options->rep_policy.values[0]);
+	assert(cache != NULL);
+	cacheSetGeometry(cache, options->mm_size, (int)options->nSA.values[0]);
+
+	/* A window of a few times the cache's blocks refills most of it */
+	warm = options->sample_warm;
+	if(warm == 0) {
+		warm = SAMPLE_WARM_BLOCKS * (options->cache_size.values[0] / options->block_size.values[0]);
+	}
+	else if(warm == SAMPLE_WARM_ALL) {
+		warm = 0;
+	}
+	sampler = samplerCreate(cache, options->sample_unit, options->sample_period, warm);
+	assert(sampler != NULL);
+
+	while(traceNext(trace, &mode, &address)) {
+		if(mode == 'R' || mode == 'W') {
+			samplerAccess(sampler, address, mode == 'W');
+		}
+	}
+	if(!runTraceCheck(options, trace)) {
+		samplerDestroy(sampler);
+		cacheDestroy(cache);
+		return(1);
+	}
+
+	target = ((options->sample_error > 0) ? options->sample_error : SAMPLE_ERROR) / 100;
+	samplerGetStats(sampler, target, &stats);
+	if(options->output == OUTPUT_SUMMARY) {
+		printf("\nSampled Simulator Output:");
+		printf("\nUnits of %lld accesses, one every %lld", options->sample_unit,
+			options->sample_period);
+		printf("\nAccesses = %lld: %lld detailed, %lld warmed, %lld skipped", stats.accesses,
+			stats.detailed, stats.warmed, stats.skipped);
+		printf("\nUnits measured = %lld", stats.units);
+		if(stats.units < 2) {
+			printf("\nToo few units for a confidence interval, use a shorter period");
+		}
+		else {
+			printf("\n\nEstimated hit rate = %f%% +/- %f%% (99.7%% confidence)",
+				stats.hit_rate * 100, stats.half_width * 100);
+			printf("\nRelative error = %f%%, target %f%%", stats.error * 100, target * 100);
+			if(stats.error <= target) {
+				printf(": met");
+			}
+			else if(stats.units_needed > 0) {
+				printf(": not met, needs about %lld units, a period of about %lld",
+					stats.units_needed, stats.accesses / stats.units_needed);
+			}
+			else {
+				printf(": not met");
+			}
+		}
+		printf("\n");
+	}
+	if(options->print_cache) {
+		printf("\n\nFinal status of the cache:");
+		cachePrint(cache);
+		printf("\n");
+	}
+
+	samplerDestroy(sampler);
+	cacheDestroy(cache);
+	return(0);
+}
+
+/* runSweep
+ *
+ * Decodes a trace once and simulates every combination of the swept
+ * options against it. Combinations that cannot be built are skipped.
+ * With a checkpoint to restore, the trace is decoded from where the
+ * checkpoint was taken and every combination starts from it.
+ *
+ * @param	options			What to simulate
+ * @param	trace			Opened trace to simulate
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int runSweep(struct Options_ *options, Trace trace) {
+	SweepPoint *points;
+	Checkpoint checkpoint = NULL;
+	unsigned long long *addresses;
+	char *modes;
+	long count;
+	int a, b, c, p, n = 0, skipped = 0;
+
+	/* Every point shares the warm-up of the checkpoint */
+	if(options->restore != NULL) {
+		checkpoint = runResume(options->restore, trace);
+		if(checkpoint == NULL) {
+			return(1);
+		}
+	}
+
+	count = traceLoad(trace, &addresses, &modes);
+	if(count < 0) {
+		fprintf(stderr, "Error: Not enough memory to load the trace\n");
+		checkpointClose(checkpoint);
+		return(1);
+	}
+	if(!runTraceCheck(options, trace)) {
+		free(addresses);
+		free(modes);
+		checkpointClose(checkpoint);
+		return(1);
+	}
+
+	points = (SweepPoint *) calloc((size_t)options->cache_size.count * options->block_size.count
+		* options->nSA.count * options->rep_policy.count, sizeof(SweepPoint));
+	if(points == NULL) {
+		fprintf(stderr, "Error: Not enough memory for the sweep\n");
+		free(addresses);
+		free(modes);
+		checkpointClose(checkpoint);
+		return(1);
+	}
+
+	for(c = 0; c < options->cache_size.count; c++) {
+		for(b = 0; b < options->block_size.count; b++) {
+			for(a = 0; a < options->nSA.count; a++) {
+				if(pointCheck(options->mm_size, options->cache_size.values[c],
+					(int)options->block_size.values[b], (int)options->nSA.values[a]) != NULL) {
+					skipped += options->rep_policy.count;
+					continue;
+				}
+				for(p = 0; p < options->rep_policy.count; p++) {
+					points[n].cache_size = options->cache_size.values[c];
+					points[n].block_size = (int)options->block_size.values[b];
+					points[n].nSA = (int)options->nSA.values[a];
+					points[n].rep_policy = (int)options->rep_policy.values[p];
+					n++;
+				}
+			}
+		}
+	}
+	if(skipped > 0) {
+		fprintf(stderr, "Warning: skipped %d configurations that cannot be built\n", skipped);
+	}
+
+	sweepRun(points, n, options->mm_size, addresses, modes, count, options->threads, checkpoint);
+	sweepPrint(points, n);
+
+	free(points);
+	free(addresses);
+	free(modes);
+	checkpointClose(checkpoint);
+	return(n == 0);
+}
+
+/* runCurve
+ *
+ * Works out the LRU hit rate of every associativity, and so of every
+ * cache size, that has the same number of sets and block size as the
+ * options, in one pass over the trace.
+ *
+ * @param	options			Cache whose sets and block size are used
+ * @param	trace			Opened trace to simulate
+ *
+ * @return	success			0
+ * @return	failure			1
+ */
+
+static int runCurve(struct Options_ *options, Trace trace) {
+	StackDist sd;
+	struct Memory_ record;
+	long long accesses, hits;
+	long ways, max_ways;
+	int set_count;
+
+	set_count = (int)(options->cache_size.values[0] / options->block_size.values[0]
+		/ options->nSA.values[0]);
+	sd = stackDistCreate((int)options->block_size.values[0], set_count);
+	if(sd == NULL) {
+		fprintf(stderr, "Error: Not enough memory for the stack distance engine\n");
+		return(1);
+	}
+
+	while(traceNext(trace, &record.mode, &record.address)) {
+		if(record.mode == 'R' || record.mode == 'W') {
+			stackDistAccess(sd, record.address);
+		}
+	}
+	if(!runTraceCheck(options, trace)) {
+		stackDistDestroy(sd);
+		return(1);
+	}
+
+	/* Every associativity up to 16, then powers of 2 */
+	accesses = stackDistAccesses(sd);
+	max_ways = stackDistMaxWays(sd);
+	printf("sets\tblock_size\tnSA\tcache_size\taccesses\thits\tmisses\thit_rate\n");
+	for(ways = 1; ; ways = (ways < 16) ? ways + 1 : ways * 2) {
+		if(ways > max_ways) {
+			ways = max_ways;
+		}
+		hits = stackDistHits(sd, ways);
+		printf("%d\t%lld\t%ld\t%lld\t%lld\t%lld\t%lld\t%f\n", set_count,
+			options->block_size.values[0], ways,
+			(long long)ways * set_count * options->block_size.values[0],
+			accesses, hits, accesses - hits,
+			accesses > 0 ? (double)hits / (double)accesses * 100 : 0.0);
+		if(ways == max_ways) {
+			break;
+		}
+	}
+
+	stackDistDestroy(sd);
+	return(0);
+}
+
+/* runHierarchy
+ *
+ * Streams a trace through a chain of cache levels and prints the
+ * counters of every level and of main memory.
+ *
+ * @param	options			Levels and inclusion policy to simulate
+ * @param	trace			Opened trace to simulate
+ *
+ * @return	success			0
+ * @return	bad levels		2
+ */
+
+static int runHierarchy(struct Options_ *options, Trace trace) {
+	static const char *inclusion_names[3] = {"nine", "inclusive", "exclusive"};
+	Hierarchy hierarchy;
+	CacheStats stats;
+	struct Memory_ record;
+	const char *reason;
+	long accesses = 0;
+	int i;
+
+	hierarchy = hierarchyCreate(options->mm_size, options->inclusion);
+	assert(hierarchy != NULL);
+	for(i = 0; i < options->level_count; i++) {
+		reason = hierarchyAddLevel(hierarchy, options->levels[i][0], (int)options->levels[i][1],
+			(int)options->levels[i][2], (int)options->levels[i][3]);
+		if(reason != NULL) {
+			fprintf(stderr, "Error: level %d: %s\n", i + 1, reason);
+			hierarchyDestroy(hierarchy);
+			return(2);
+		}
+	}
+
+	while(traceNext(trace, &record.mode, &record.address)) {
+		if(record.mode == 'R' || record.mode == 'W') {
+			hierarchyAccess(hierarchy, record.address, record.mode == 'W');
+			accesses++;
+		}
+	}
+	if(!runTraceCheck(options, trace)) {
+		hierarchyDestroy(hierarchy);
+		return(1);
+	}
+
+	printf("level\tcache_size\tblock_size\tnSA\tpolicy\tinclusion\taccesses\thits\tmisses\treads\twrites\thit_rate\n");
+	for(i = 0; i < options->level_count; i++) {
+		hierarchyGetStats(hierarchy, i, &stats);
+		printf("L%d\t%lld\t%lld\t%lld\t%s\t%s\t%lld\t%lld\t%lld\t%lld\t%lld\t%f\n", i + 1,
+			options->levels[i][0], options->levels[i][1], options->levels[i][2],
+			cachePolicyName((int)options->levels[i][3]), inclusion_names[options->inclusion],
+			stats.hits + stats.misses, stats.hits, stats.misses, stats.reads, stats.writes,
+			stats.hits + stats.misses > 0
+				? (double)stats.hits / (double)(stats.hits + stats.misses) * 100 : 0.0);
+	}
+	hierarchyGetStats(hierarchy, options->level_count, &stats);
+	printf("memory\t\t\t\t\t\t%ld\t\t\t%lld\t%lld\t\n", accesses, stats.reads, stats.writes);
+
+	hierarchyDestroy(hierarchy);
+	return(0);
+}
+
+/* runMulticore
+ *
+ * Replays a multicore trace through a private cache per core, given by
+ * the first level, and an optional shared level, given by the second,
+ * and prints the counters of every core and of the shared level.
+ *
+ * @param	options			Levels, cores, and threads to use
+ * @param	trace			Opened trace to replay
+ *
+ * @return	success			0
+ * @return	failure			1
+ * @return	bad levels		2
+ */
+
+static int runMulticore(struct Options_ *options, Trace trace) {
+	Multicore mc;
+	CoreStats stats, total = {0};
+	CacheStats below;
+	const char *reason = NULL;
+	long long skipped;
+	int c;
+
+	mc = multicoreCreate(options->mm_size, options->cores, options->levels[0][0],
+		(int)options->levels[0][1], (int)options->levels[0][2], (int)options->levels[0][3]);
+	if(mc == NULL) {
+		fprintf(stderr, "Error: level 1: private caches cannot use OPT\n");
+		return(2);
+	}
+	if(options->level_count > 1) {
+		reason = multicoreSetShared(mc, options->levels[1][0], (int)options->levels[1][1],
+			(int)options->levels[1][2], (int)options->levels[1][3]);
+	}
+	if(reason != NULL) {
+		fprintf(stderr, "Error: level 2: %s\n", reason);
+		multicoreDestroy(mc);
+		return(2);
+	}
+
+	skipped = multicoreRun(mc, trace, options->threads);
+	if(skipped < 0) {
+		fprintf(stderr, "Error: Could not start the core threads\n");
+		multicoreDestroy(mc);
+		return(1);
+	}
+	if(!runTraceCheck(options, trace)) {
+		multicoreDestroy(mc);
+		return(1);
+	}
+	if(skipped > 0) {
+		fprintf(stderr, "Warning: skipped %lld accesses from cores past %d\n", skipped,
+			options->cores - 1);
+	}
+
+	printf("core\taccesses\thits\tmisses\tupgrades\tinvalidations\twritebacks\ttransfers\thit_rate\n");
+	for(c = 0; c < options->cores; c++) {
+		multicoreGetStats(mc, c, &stats);
+		printf("%d\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%f\n", c, stats.accesses,
+			stats.hits, stats.misses, stats.upgrades, stats.invalidations, stats.writebacks,
+			stats.transfers, stats.accesses > 0 ? (double)stats.hits / (double)stats.accesses * 100 : 0.0);
+		total.accesses += stats.accesses;
+		total.hits += stats.hits;
+		total.misses += stats.misses;
+		total.upgrades += stats.upgrades;
+		total.invalidations += stats.invalidations;
+		total.writebacks += stats.writebacks;
+		total.transfers += stats.transfers;
+	}
+	printf("all\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%f\n", total.accesses,
+		total.hits, total.misses, total.upgrades, total.invalidations, total.writebacks,
+		total.transfers, total.accesses > 0 ? (double)total.hits / (double)total.accesses * 100 : 0.0);
+
+	/* Every miss and upgrade is one bus request */
+	printf("\ncoherence requests = %lld, invalidations = %lld\n",
+		total.misses + total.upgrades, total.invalidations);
+	if(multicoreGetShared(mc, &below)) {
+		printf("shared level: accesses = %lld, hits = %lld, misses = %lld, reads = %lld, writes = %lld\n",
+			below.hits + below.misses, below.hits, below.misses, below.reads, below.writes);
+	}
+	else {
+		printf("main memory: reads = %lld, writes = %lld\n", below.reads, below.writes);
+	}
+
+	multicoreDestroy(mc);
+	return(0);
+}
+
+/* usagePrint
+ *
+ * Prints the command line options.
+ *
+ * @param	name			Name the program was run as
+ *
+ * @return	void
+ */
+
+static void usagePrint(const char *name) {
+	printf("Usage: %s [options]\n", name);
+	printf("With no options the simulator prompts for each setting.\n\n");
+	printf("  -m, --mm-size BYTES      Size of main memory\n");
+	printf("  -c, --cache-size BYTES   Size of the cache\n");
+	printf("  -b, --block-size BYTES   Size of a cache block/line\n");
+	printf("  -a, --assoc N            Degree of set-associativity\n");
+	printf("  -p, --policy NAME        Replacement policy, LRU, FIFO, OPT, Random, PLRU,\n");
+	printf("                           LFU, SRRIP, or BRRIP; L, F, O, R, P, S, B for short\n");
+	printf("  -t, --trace FILE         Trace to simulate, - for stdin\n");
+	printf("  -j, --threads N          Threads to use for a sweep, multicore run, or cache\n");
+	printf("  -r, --mrc                Print the LRU hit rate of every associativity\n");
+	printf("                           with the same sets and block size, in one pass\n");
+	printf("  -o, --opt-bound          Also print the OPT hit rate of the same cache\n");
+	printf("  -C, --classify           Sort misses into compulsory, capacity, and\n");
+	printf("                           conflict misses, overall and per set\n");
+	printf("  -L, --level SIZE:BLOCK:ASSOC:POLICY\n");
+	printf("                           Add a level to a cache hierarchy, first level\n");
+	printf("                           first; replaces -c, -b, -a, and -p\n");
+	printf("  -I, --inclusion MODE     Hierarchy inclusion: nine (default), inclusive,\n");
+	printf("                           or exclusive\n");
+	printf("  -n, --cores N            Replay a multicore trace with MESI coherence:\n");
+	printf("                           the first -L level is private to each core,\n");
+	printf("                           and a second one is shared\n");
+	printf("  -f, --config FILE        Read \"name = value\" options from FILE\n");
+	printf("  -v, --verbose            Print every memory access\n");
+	printf("  -s, --print-cache        Print the final status of the cache\n");
+	printf("  -O, --output FORMAT      summary (default), none, or a log of every\n");
+	printf("                           access as csv or binary\n");
+	printf("  -l, --log FILE           Write the csv or binary log to FILE instead of\n");
+	printf("                           stdout, and still print the summary\n");
+	printf("  -S, --stats FILE         Write per-set counters, eviction age and reuse\n");
+	printf("                           distance histograms, hot blocks and sets, and\n");
+	printf("                           simulator speed as JSON to FILE, - for stdout\n");
+	printf("  -u, --sample UNIT:PERIOD Simulate UNIT accesses in detail out of every\n");
+	printf("                           PERIOD and estimate the hit rate from them\n");
+	printf("  -w, --sample-warm N      Only warm the cache with the N accesses before\n");
+	printf("                           each unit and skip the rest, or \"all\" to warm\n");
+	printf("                           with every access. A window too small for the\n");
+	printf("                           cache biases the hit rate low; all avoids that\n");
+	printf("                           but is slower (default: %d times the cache's\n",
+		SAMPLE_WARM_BLOCKS);
+	printf("                           blocks)\n");
+	printf("  -e, --sample-error PCT   Relative error target of the estimate at 99.7%%\n");
+	printf("                           confidence (default: 3)\n");
+	printf("  -k, --checkpoint FILE    Save the whole cache to FILE once -K accesses\n");
+	printf("                           have run, then carry on\n");
+	printf("  -K, --checkpoint-at N    Access count at which -k saves the cache\n");
+	printf("  -R, --restore FILE       Start from a checkpoint instead of a cold cache,\n");
+	printf("                           skipping the accesses it has already seen\n");
+	printf("  -W, --warmup N           Only warm the cache with the first N accesses,\n");
+	printf("                           and count the rest\n");
+	printf("  -M, --roi                Only count the accesses between B and E marker\n");
+	printf("                           lines of the trace, and warm with the rest\n");
+	printf("  -h, --help               Print this help\n");
+	printf("\nGiving -c, -b, -a, or -p a comma separated list, such as -a 1,2,4,\n");
+	printf("sweeps every combination in one pass over the trace and prints\n");
+	printf("one table of results.\n");
+}
+
+/* batchMain
+ *
+ * Runs one simulation from command line options, without prompting.
+ * Options are applied in order, so options after -f override the
+ * config file.
+ *
+ * @param	argc			Argument count
+ * @param	argv			Arguments
+ *
+ * @return	success			0
+ * @return	bad trace		1
+ * @return	bad options		2
+ */
+
+static int batchMain(int argc, char **argv) {
+	static const struct option long_options[] = {
+		{"mm-size", required_argument, NULL, 'm'},
+		{"cache-size", required_argument, NULL, 'c'},
+		{"block-size", required_argument, NULL, 'b'},
+		{"assoc", required_argument, NULL, 'a'},
+		{"policy", required_argument, NULL, 'p'},
+		{"trace", required_argument, NULL, 't'},
+		{"threads", required_argument, NULL, 'j'},
+		{"mrc", no_argument, NULL, 'r'},
+		{"opt-bound", no_argument, NULL, 'o'},
+		{"classify", no_argument, NULL, 'C'},
+		{"level", required_argument, NULL, 'L'},
+		{"inclusion", required_argument, NULL, 'I'},
+		{"cores", required_argument, NULL, 'n'},
+		{"config", required_argument, NULL, 'f'},
+		{"verbose", no_argument, NULL, 'v'},
+		{"print-cache", no_argument, NULL, 's'},
+		{"output", required_argument, NULL, 'O'},
+		{"log", required_argument, NULL, 'l'},
+		{"stats", required_argument, NULL, 'S'},
+		{"sample", required_argument, NULL, 'u'},
+		{"sample-warm", required_argument, NULL, 'w'},
+		{"sample-error", required_argument, NULL, 'e'},
+		{"checkpoint", required_argument, NULL, 'k'},
+		{"checkpoint-at", required_argument, NULL, 'K'},
+		{"restore", required_argument, NULL, 'R'},
+		{"warmup", required_argument, NULL, 'W'},
+		{"roi", no_argument, NULL, 'M'},
+		{"help", no_argument, NULL, 'h'},
+		{NULL, 0, NULL, 0}
+	};
+	struct Options_ options = {0};
+	Trace trace;
+	long cpus;
+	int opt, i, status, ok = 1;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	options.threads = (cpus > 0) ? (int)cpus : 1;
+
+	while(ok && (opt = getopt_long(argc, argv, "m:c:b:a:p:t:j:roCL:I:n:f:vsO:l:S:u:w:e:k:K:R:W:Mh", long_options, NULL)) != -1) {
+		switch(opt) {
+			case 'f':
+				ok = optionsLoad(&options, optarg);
+				break;
+			case 'r':
+				options.mrc = 1;
+				break;
+			case 'o':
+				options.opt_bound = 1;
+				break;
+			case 'C':
+				options.classify = 1;
+				break;
+			case 'M':
+				options.roi = 1;
+				break;
+			case 'v':
+				options.print_memory = 1;
+				break;
+			case 's':
+				options.print_cache = 1;
+				break;
+			case 'h':
+				usagePrint(argv[0]);
+				free(options.filename);
+				free(options.log);
+				free(options.stats);
+				free(options.checkpoint);
+				free(options.restore);
+				return(0);
+			case '?':
+				ok = 0;
+				break;
+			default:
+				for(i = 0; long_options[i].name != NULL; i++) {
+					if(long_options[i].val == opt) {
+						break;
+					}
+				}
+				ok = optionSet(&options, long_options[i].name, optarg);
+				if(!ok) {
+					fprintf(stderr, "Error: bad value for --%s: %s\n", long_options[i].name, optarg);
+				}
+				break;
+		}
+	}
+	if(ok && optind < argc) {
+		fprintf(stderr, "Error: unexpected argument %s\n", argv[optind]);
+		ok = 0;
+	}
+	if(!ok || !optionsCheck(&options)) {
+		fprintf(stderr, "Try %s --help\n", argv[0]);
+		free(options.filename);
+		free(options.log);
+		free(options.stats);
+		free(options.checkpoint);
+		free(options.restore);
+		return(2);
+	}
+
+	trace = traceOpen(options.filename);
+	if(trace == NULL) {
+		fprintf(stderr, "Error: Could not open file %s\n", options.filename);
+		free(options.filename);
+		free(options.log);
+		free(options.stats);
+		free(options.checkpoint);
+		free(options.restore);
+		return(1);
+	}
+	traceSetLimit(trace, (unsigned long long)options.mm_size);
+
+	if(options.cores > 0) {
+		status = runMulticore(&options, trace);
+	}
+	else if(options.level_count > 0) {
+		status = runHierarchy(&options, trace);
+	}
+	else if(options.mrc) {
+		status = runCurve(&options, trace);
+	}
+	else if(optionsSweep(&options)) {
+		status = runSweep(&options, trace);
+	}
+	else if(options.sample_period > 0) {
+		status = runSampled(&options, trace);
+	}
+	else {
+		status = runSimulation(&options, trace);
+	}
+
+	traceClose(trace);
+	free(options.filename);
+	free(options.log);
+	free(options.stats);
+	free(options.checkpoint);
+	free(options.restore);
+	return(status);
+}
+
+int main(int argc, char **argv) {
+	int goAgain = 1;
+
+	if(argc > 1) {
+		return(batchMain(argc, argv));
+	}
+
+	do {
+	struct Options_ options = {0};
+	Trace trace;
+
+	int i, valid;
+	long long mm_size = 0, cache_size = 0;
+	int block_size = 0, nSA = 0, rep_policy = 0;
+	char input[128];
+	char *filename = "N/A";
+
+	/* Validate Inputs */
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	mm_size = getUserInt("\nEnter the size of the main memory in bytes: ", LLONG_MAX, 4);
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	cache_size = getUserInt("\nEnter the size of the cache in bytes: ", mm_size, 2);
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	block_size = (int)getUserInt("\nEnter the cache block/line size: ",
+		(cache_size < INT_MAX) ? cache_size : INT_MAX, 2);
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	nSA = (int)getUserInt("\nEnter the degrees of set-associativity: ", block_size, 1);
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	do {
+		printf("\nEnter the replacement policy (L/F/O/R/P/LFU/S/B): ");
+		fgets(input, sizeof(input), stdin);
+		for(i = 0; i < sizeof(input); i++) {
+			if(input[i] == '\n') {
+				input[i] = '\0';
+			}
+		}
+		rep_policy = parsePolicy(input);
+		valid = (rep_policy != 0);
+	} while(!valid);
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+	do {
+		printf("\nEnter the name of the input file: ");
+		fgets(input, sizeof(input), stdin);
+		for(i = 0; i < sizeof(input); i++) {
+			if(input[i] == '\n') {
+				input[i] = '\0';
+			}
+		}
+		valid = 1;
+		filename = input;
+		trace = traceOpen(filename);
+		if(trace == NULL) {
+			printf("\nError: Could not open file %s", filename);
+			valid = 0;
+		}
+	} while(!valid);
+
+	/* Print out final input status */
+	inputPrint(mm_size, cache_size, block_size, nSA, rep_policy, filename);
+
+	do {
+		printf("\nPrint every memory access? (y/n): ");
+		fgets(input, sizeof(input), stdin);
+		valid = 0;
+		if(input[0] == 'y') {
+			options.print_memory = 1;
+			valid = 1;
+		}
+		else if(input[0] == 'n') {
+			options.print_memory = 0;
+			valid = 1;
+		}
+	} while(!valid);
+
+	options.mm_size = mm_size;
+	optionListSet(&options.cache_size, cache_size);
+	optionListSet(&options.block_size, block_size);
+	optionListSet(&options.nSA, nSA);
+	optionListSet(&options.rep_policy, rep_policy);
+	options.opt_bound = 1;
+	options.print_cache = 1;
+	options.print_tags = 1;
+	traceSetLimit(trace, (unsigned long long)mm_size);
+	runSimulation(&options, trace);
+
+	/* Close the trace */
+	traceClose(trace);
+
+	do {
+		printf("\nContinue? (y/n): ");
+		fgets(input, sizeof(input), stdin);
+		for(i = 0; i < sizeof(input); i++) {
+			if(input[i] == '\n') {
+				input[i] = '\0';
+			}
+		}
+		valid = 0;
+		if(input[0] == 'y') {
+			goAgain = 1;
+			valid = 1;
+		}
+		else if(input[0] == 'n') {
+			goAgain = 0;
+			valid = 1;
+		}
+	} while(!valid);
+
+} while(goAgain);
+
+	screenClear();
+	printf("\n\n\n\nHave a nice day :)\n\n\n\n");
+
+	return(0);
+}
+#endif
+
+/* cacheConfigCheck
+ *
+ * Checks that a config describes a cache that can be built.
+ *
+ * @param	config			Config to check
+ *
+ * @return	valid			NULL
+ * @return	invalid			Reason the config is invalid
+ */
+
+const char *cacheConfigCheck(const CacheConfig *config) {
+	long long block_count;
+
+	if(config->mm_size < 4) {
+		return("mm-size must be at least 4");
+	}
+	if(config->cache_size < 2 || config->cache_size > config->mm_size) {
+		return("cache-size must be between 2 and mm-size");
+	}
+	if(config->block_size < 2 || config->block_size > config->cache_size) {
+		return("block-size must be between 2 and cache-size");
+	}
+	block_count = config->cache_size / config->block_size;
+	if(block_count > INT_MAX) {
+		return("cache-size / block-size must be below 2^31");
+	}
+	if(config->nSA < 1 || config->nSA > block_count || block_count % config->nSA != 0) {
+		return("assoc must divide the number of cache blocks");
+	}
+	if(policyName(config->rep_policy) == NULL) {
+		return("unknown replacement policy");
+	}
+
+	return(NULL);
+}
+
+/* cacheCreateConfig
+ *
+ * Creates a cache from a config, with its geometry set and its miss
+ * classification and profile turned on as asked, ready for accesses.
+ * Caches share no state, so each one can be used from its own thread.
+ * Returns NULL if the config is invalid or memory runs out.
+ *
+ * @param	config			What to build
+ *
+ * @return	success			cache
+ * @return	failure			NULL
+ */
+
+Cache cacheCreateConfig(const CacheConfig *config) {
+	Cache cache;
+
+	if(config == NULL || cacheConfigCheck(config) != NULL) {
+		return NULL;
+	}
+
+	cache = cacheCreate(config->cache_size, config->block_size, config->rep_policy);
+	if(cache == NULL) {
+		return NULL;
+	}
+	cacheSetGeometry(cache, config->mm_size, config->nSA);
+	cacheSetClassify(cache, config->classify);
+	cacheSetProfile(cache, config->profile);
+
+	return(cache);
+}
+
+/* cacheCreate
+ *
+ * Function to create a new cache struct. Returns the new struct on success
+ * and NULL on failure.
+ *
+ * @param	cache_size		Size of cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ *
+ * @return	success			cache
+ * @return	failure			NULL
+ */
+
+Cache cacheCreate(long long cache_size, int block_size, int rep_policy) {
+	Cache cache;
+	int words;
+
+	if(policyName(rep_policy) == NULL) {
+		fprintf(stderr, "\nUnknown replacement policy.");
+		return NULL;
+	}
+
+	cache = (Cache) malloc(sizeof(struct Cache_));
+	if(cache == NULL) {
+		fprintf(stderr, "\nCould not allocate memory for cache.");
+		return NULL;
+	}
+
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->reads = 0;
+	cache->writes = 0;
+	cache->classes[CACHE_COMPULSORY] = 0;
+	cache->classes[CACHE_CAPACITY] = 0;
+	cache->classes[CACHE_CONFLICT] = 0;
+
+	cache->cache_size = cache_size;
+	cache->block_size = block_size;
+	cache->rep_policy = rep_policy;
+
+	/* Geometry is filled in by cacheSetGeometry */
+	cache->mm_size = 0;
+	cache->nSA = 1;
+	cache->set_count = 1;
+	cache->addr_size[0] = 0;
+	cache->addr_size[1] = 0;
+	cache->addr_size[2] = 0;
+	cache->addr_size[3] = 0;
+	cache->addr_size[4] = 0;
+	cache->decode_shift = 0;
+	cache->set_mask = 0;
+	cache->tags = NULL;
+	cache->wide_tags = NULL;
+	cache->policy = NULL;
+	cache->evicted = 0;
+	cache->evict_address = 0;
+	cache->evict_dirty = 0;
+	cache->shadow = NULL;
+	cache->set_classes = NULL;
+	cache->profile = NULL;
+
+	/* Calculate block_count */
+	cache->block_count = (int)(cache_size / block_size);
+
+	/* All blocks start out invalid and clean. Tags are allocated by
+	 * cacheSetGeometry, once their width is known */
+	words = (cache->block_count + 63) / 64;
+	cache->valid = (unsigned long long *) calloc(words, sizeof(unsigned long long));
+	cache->dirty = (unsigned long long *) calloc(words, sizeof(unsigned long long));
+	assert(cache->valid != NULL && cache->dirty != NULL);
+
+	return(cache);
+}
+
+/* cacheDestroy
+ * 
+ * Function that destroys a created cache. Frees all allocated memory. If 
+ * you pass in NULL, nothing happens. So make sure to set your cache = NULL
+ * after you destroy it to prevent a double free.
+ *
+ * @param	cache			Target cache object to be destroyed
+ *
+ * @return	void
+ */
+
+void cacheDestroy(Cache cache) {
+	if(cache != NULL) {
+		free(cache->tags);
+		free(cache->wide_tags);
+		policyDestroy(cache->policy);
+		free(cache->valid);
+		free(cache->dirty);
+		shadowDestroy(cache->shadow);
+		free(cache->set_classes);
+		profileDestroy(cache->profile);
+		free(cache);
+	}
+
+	return;
+}
+
+/* cacheSetGeometry
+ *
+ * Sets the main memory size and set-associativity of a created cache
+ * and works out the number of sets and the width of each address
+ * field. Tags are kept in 32 bits each unless the largest tag of main
+ * memory needs more. Must be called before any reads or writes.
+ *
+ * @param	cache			Target cache struct
+ * @param	mm_size			Size of main memory in bytes
+ * @param	nSA				Set-Associativity
+ *
+ * @return	void
+ */
+
+void cacheSetGeometry(Cache cache, long long mm_size, int nSA) {
+	unsigned long long max_tag;
+
+	cache->mm_size = mm_size;
+	cache->nSA = nSA;
+	cache->set_count = cache->block_count / cache->nSA;
+
+	cache->addr_size[0] = ceil_log2(cache->mm_size);
+	cache->addr_size[1] = ceil_log2(cache->block_size);
+	cache->addr_size[2] = ceil_log2(cache->set_count);
+	cache->addr_size[3] = cache->addr_size[0] - cache->addr_size[1] - cache->addr_size[2];
+
+	/* Shifts and masks only line up with the fields for powers of 2 */
+	cache->decode_shift = ((cache->block_size & (cache->block_size - 1)) == 0)
+		&& ((cache->set_count & (cache->set_count - 1)) == 0);
+	cache->set_mask = cache->set_count - 1;
+
+	free(cache->tags);
+	free(cache->wide_tags);
+	cache->tags = NULL;
+	cache->wide_tags = NULL;
+	max_tag = (mm_size > 0) ? (unsigned long long)(mm_size - 1) / cache->block_size
+		/ cache->set_count : 0;
+	if(max_tag > 0xFFFFFFFFull) {
+		cache->wide_tags = (unsigned long long *) calloc(cache->block_count,
+			sizeof(unsigned long long));
+		assert(cache->wide_tags != NULL);
+	}
+	else {
+		cache->tags = (unsigned int *) calloc(cache->block_count, sizeof(unsigned int));
+		assert(cache->tags != NULL);
+	}
+
+	policyDestroy(cache->policy);
+	cache->policy = policyCreate(cache->rep_policy, cache->set_count, cache->nSA);
+}
+
+/* cacheSetClassify
+ *
+ * Turns miss classification on or off. When on, every miss is counted
+ * as compulsory, capacity, or conflict, overall and for each set, with
+ * the help of a fully associative LRU shadow cache of the same size.
+ * Must be called after cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	classify		0 = Off, 1 = Classify misses
+ *
+ * @return	void
+ */
+
+void cacheSetClassify(Cache cache, int classify) {
+	shadowDestroy(cache->shadow);
+	free(cache->set_classes);
+	cache->shadow = NULL;
+	cache->set_classes = NULL;
+
+	if(classify) {
+		cache->shadow = shadowCreate(cache->block_count);
+		cache->set_classes = (long long *) calloc((size_t)cache->set_count * 3, sizeof(long long));
+		assert(cache->shadow != NULL && cache->set_classes != NULL);
+	}
+}
+
+/* cacheSetProfile
+ *
+ * Turns detailed statistics on or off. When on, every access is
+ * counted in a Profile of per-set counters, eviction age and reuse
+ * distance histograms, and per-block use counts. Must be called after
+ * cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	profile			0 = Off, 1 = Keep a profile
+ *
+ * @return	void
+ */
+
+void cacheSetProfile(Cache cache, int profile) {
+	profileDestroy(cache->profile);
+	cache->profile = NULL;
+
+	if(profile) {
+		cache->profile = profileCreate(cache->set_count, cache->block_count);
+		assert(cache->profile != NULL);
+	}
+}
+
+/* cacheGetProfile
+ *
+ * Gives the profile of a cache.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	profile			Profile, or NULL when it is turned off
+ */
+
+Profile cacheGetProfile(Cache cache) {
+	return(cache->profile);
+}
+
+/* cacheSetShard
+ *
+ * Marks a cache as holding only sets shard, shard + shards, and so on
+ * of a bigger cache, as the set-sharded engine builds them. Per-set
+ * random state is then seeded from the set # in the bigger cache, so
+ * a policy like Random picks the same victims in either. Must be
+ * called after cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	shard			Set # of set 0 in the bigger cache
+ * @param	shards			Number of caches the bigger one is split into
+ *
+ * @return	void
+ */
+
+void cacheSetShard(Cache cache, int shard, int shards) {
+	policySeed(cache->policy, shard, shards);
+}
+
+/* cacheFootprint
+ *
+ * Works out how many bytes of host memory the block state of a cache
+ * takes up. The cache struct itself and the memory records are not
+ * counted.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	bytes			Bytes used by the block arrays
+ */
+
+long cacheFootprint(Cache cache) {
+	long words;
+
+	words = (cache->block_count + 63) / 64;
+	return((long)cache->block_count * (long)((cache->wide_tags != NULL)
+		? sizeof(unsigned long long) : sizeof(unsigned int))
+		+ 2 * words * (long)sizeof(unsigned long long) + policyFootprint(cache->policy));
+}
+
+/* cachePolicyName
+ *
+ * Gives the name of a replacement policy.
+ *
+ * @param	rep_policy		Replacement policy number
+ *
+ * @return	known			Name of the policy, such as "LRU"
+ * @return	unknown			"N/A"
+ */
+
+const char *cachePolicyName(int rep_policy) {
+	const char *name;
+
+	name = policyName(rep_policy);
+	return((name != NULL) ? name : "N/A");
+}
+
+/* cacheGetStats
+ *
+ * Copies the counters of a cache.
+ *
+ * @param	cache			Target cache struct
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void cacheGetStats(Cache cache, CacheStats *stats) {
+	stats->hits = cache->hits;
+	stats->misses = cache->misses;
+	stats->reads = cache->reads;
+	stats->writes = cache->writes;
+	stats->compulsory = cache->classes[CACHE_COMPULSORY];
+	stats->capacity = cache->classes[CACHE_CAPACITY];
+	stats->conflict = cache->classes[CACHE_CONFLICT];
+}
+
+/* cacheResetStats
+ *
+ * Zeroes the hit, miss, and memory traffic counters of a cache and its
+ * miss classes, leaving its blocks and replacement state as they are.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	void
+ */
+
+void cacheResetStats(Cache cache) {
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->reads = 0;
+	cache->writes = 0;
+	memset(cache->classes, 0, sizeof(cache->classes));
+	if(cache->set_classes != NULL) {
+		memset(cache->set_classes, 0, sizeof(long long) * 3 * (size_t)cache->set_count);
+	}
+}
+
+/* cacheSave
+ *
+ * Writes the whole state of a cache to a file, so that a run can go on
+ * from it later: its geometry, policy, counters, tags, valid and dirty
+ * bits, and replacement metadata, as they are held in memory. Miss
+ * classes per set and the profile are not saved.
+ *
+ * @param	cache			Target cache struct
+ * @param	file			File to write to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int cacheSave(Cache cache, FILE *file) {
+	long long fields[CACHE_SAVE_FIELDS];
+	size_t words;
+	int ok;
+
+	fields[0] = cache->mm_size;
+	fields[1] = cache->cache_size;
+	fields[2] = cache->block_size;
+	fields[3] = cache->nSA;
+	fields[4] = cache->rep_policy;
+	fields[5] = cache->hits;
+	fields[6] = cache->misses;
+	fields[7] = cache->reads;
+	fields[8] = cache->writes;
+	memcpy(&fields[9], cache->classes, sizeof(cache->classes));
+
+	words = ((size_t)cache->block_count + 63) / 64;
+	ok = (fwrite(fields, sizeof(fields), 1, file) == 1);
+	if(ok && cache->wide_tags != NULL) {
+		ok = (fwrite(cache->wide_tags, sizeof(unsigned long long), cache->block_count, file)
+			== (size_t)cache->block_count);
+	}
+	else if(ok) {
+		ok = (fwrite(cache->tags, sizeof(unsigned int), cache->block_count, file)
+			== (size_t)cache->block_count);
+	}
+	ok = ok && fwrite(cache->valid, sizeof(unsigned long long), words, file) == words;
+	ok = ok && fwrite(cache->dirty, sizeof(unsigned long long), words, file) == words;
+
+	return(ok && policySave(cache->policy, file));
+}
+
+/* cacheRestore
+ *
+ * Puts back the state written by cacheSave into a cache built with
+ * the same main memory size, cache size, block size, and associativity.
+ * Must be called after cacheSetGeometry and before any accesses. If the
+ * cache uses another policy, the blocks and counters are still put
+ * back, but its replacement metadata starts out fresh, so many policies
+ * can start from one warm cache.
+ *
+ * @param	cache			Target cache struct
+ * @param	data			Saved state, such as a mapped file
+ * @param	size			Bytes of saved state
+ *
+ * @return	success			1
+ * @return	mismatch		0
+ */
+
+int cacheRestore(Cache cache, const void *data, long size) {
+	long long fields[CACHE_SAVE_FIELDS];
+	const unsigned char *p = (const unsigned char *)data;
+	long tag_bytes, bit_bytes, policy_bytes;
+
+	if(size < (long)sizeof(fields)) {
+		return(0);
+	}
+	memcpy(fields, p, sizeof(fields));
+	if(fields[0] != cache->mm_size || fields[1] != cache->cache_size
+		|| fields[2] != cache->block_size || fields[3] != cache->nSA) {
+		return(0);
+	}
+
+	/* Check every size before anything is changed */
+	tag_bytes = (long)cache->block_count
+		* (long)((cache->wide_tags != NULL) ? sizeof(unsigned long long) : sizeof(unsigned int));
+	bit_bytes = (((long)cache->block_count + 63) / 64) * (long)sizeof(unsigned long long);
+	policy_bytes = size - (long)sizeof(fields) - tag_bytes - 2 * bit_bytes;
+	if(policy_bytes < 0 || (fields[4] == cache->rep_policy
+		&& policy_bytes != POLICY_SAVE_HEADER + policyFootprint(cache->policy))) {
+		return(0);
+	}
+
+	cache->hits = fields[5];
+	cache->misses = fields[6];
+	cache->reads = fields[7];
+	cache->writes = fields[8];
+	memcpy(cache->classes, &fields[9], sizeof(cache->classes));
+	p += sizeof(fields);
+	memcpy((cache->wide_tags != NULL) ? (void *)cache->wide_tags : (void *)cache->tags, p,
+		tag_bytes);
+	p += tag_bytes;
+	memcpy(cache->valid, p, bit_bytes);
+	p += bit_bytes;
+	memcpy(cache->dirty, p, bit_bytes);
+	p += bit_bytes;
+	if(fields[4] == cache->rep_policy) {
+		policyRestore(cache->policy, p, policy_bytes);
+	}
+	cache->evicted = 0;
+
+	return(1);
+}
+
+/* cacheGetSetMisses
+ *
+ * Gives the number of misses of one class in one set. Only counted
+ * while miss classification is on.
+ *
+ * @param	cache			Target cache struct
+ * @param	set				Cache set #
+ * @param	miss_class		CACHE_COMPULSORY, CACHE_CAPACITY, or CACHE_CONFLICT
+ *
+ * @return	misses			# of misses of that class in the set
+ */
+
+long long cacheGetSetMisses(Cache cache, int set, int miss_class) {
+	if(cache->set_classes == NULL) {
+		return(0);
+	}
+
+	return(cache->set_classes[set * 3 + miss_class]);
+}
+
+/* cacheDecode
+ *
+ * Splits an address into its main memory block #, set, and tag.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	mm_block		Set to the main memory block #
+ * @param	set				Set to the cache set #
+ * @param	tag				Set to the tag
+ *
+ * @return	void
+ */
+
+static inline void cacheDecode(Cache cache, unsigned long long address,
+	unsigned long long *mm_block, int *set, unsigned long long *tag) {
+	if(cache->decode_shift) {
+		*mm_block = address >> cache->addr_size[1];
+		*set = (int)(*mm_block & cache->set_mask);
+		*tag = *mm_block >> cache->addr_size[2];
+	}
+	else {
+		*mm_block = address / (unsigned int)cache->block_size;
+		*set = (int)(*mm_block % (unsigned int)cache->set_count);
+		*tag = *mm_block / (unsigned int)cache->set_count;
+	}
+}
+
+#if CACHE_PROBE_LANES > 1
+/* cacheProbe
+ *
+ * Compares CACHE_PROBE_LANES packed tags against one tag in a single
+ * vector compare.
+ *
+ * @param	tags			First of the tags to compare
+ * @param	tag				Tag to look for
+ *
+ * @return	match			Bit i set if tags[i] == tag
+ */
+
+static inline unsigned int cacheProbe(const unsigned int *tags, unsigned int tag) {
+#if CACHE_PROBE_LANES == 8
+	__m256i key = _mm256_set1_epi32((int)tag);
+	__m256i row = _mm256_loadu_si256((const __m256i *)tags);
+
+	return((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(row, key))));
+#else
+	__m128i key = _mm_set1_epi32((int)tag);
+	__m128i row = _mm_loadu_si128((const __m128i *)tags);
+
+	return((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(row, key))));
+#endif
+}
+
+/* cacheProbeWide
+ *
+ * Compares CACHE_PROBE_WIDE_LANES packed 64 bit tags against one tag
+ * in a single vector compare. SSE2 has no 64 bit compare, so there a
+ * lane matches when both of its 32 bit halves do.
+ *
+ * @param	tags			First of the tags to compare
+ * @param	tag				Tag to look for
+ *
+ * @return	match			Bit i set if tags[i] == tag
+ */
+
+static inline unsigned int cacheProbeWide(const unsigned long long *tags,
+	unsigned long long tag) {
+#if CACHE_PROBE_LANES == 8
+	__m256i key = _mm256_set1_epi64x((long long)tag);
+	__m256i row = _mm256_loadu_si256((const __m256i *)tags);
+
+	return((unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(row, key))));
+#else
+	__m128i key = _mm_set1_epi64x((long long)tag);
+	__m128i row = _mm_loadu_si128((const __m128i *)tags);
+	__m128i equal = _mm_cmpeq_epi32(row, key);
+
+	equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+	return((unsigned int)_mm_movemask_pd(_mm_castsi128_pd(equal)));
+#endif
+}
+#endif
+
+/* cacheFindWideWay
+ *
+ * cacheFindWay for caches whose tags need more than 32 bits, comparing
+ * CACHE_PROBE_WIDE_LANES ways at a time with cacheProbeWide.
+ *
+ * @param	cache			Target cache struct
+ * @param	set				Cache set #
+ * @param	tag				Tag to look for
+ *
+ * @return	found			Block # holding the tag
+ * @return	not found		-1
+ */
+
+static int cacheFindWideWay(Cache cache, int set, unsigned long long tag) {
+	int i, first, last;
+#if CACHE_PROBE_LANES > 1
+	unsigned int match;
+	int way;
+#endif
+
+	first = set * cache->nSA;
+	last = first + cache->nSA;
+	i = first;
+#if CACHE_PROBE_LANES > 1
+	for(; i + CACHE_PROBE_WIDE_LANES <= last; i += CACHE_PROBE_WIDE_LANES) {
+		match = cacheProbeWide(cache->wide_tags + i, tag);
+		while(match != 0) {
+			way = i + __builtin_ctz(match);
+			if(bitTest(cache->valid, way)) {
+				return(way);
+			}
+			match &= match - 1;
+		}
+	}
+#endif
+	for(; i < last; i++) {
+		if(cache->wide_tags[i] == tag && bitTest(cache->valid, i)) {
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/* cacheFindWay
+ *
+ * Looks for a tag among the ways of a set. Whole groups of
+ * CACHE_PROBE_LANES ways are compared with cacheProbe, and only the
+ * ways whose tag matches have their valid bit checked. Any ways left
+ * over are compared one at a time. Wide tags go to cacheFindWideWay.
+ *
+ * @param	cache			Target cache struct
+ * @param	set				Cache set #
+ * @param	tag				Tag to look for
+ *
+ * @return	found			Block # holding the tag
+ * @return	not found		-1
+ */
+
+static inline int cacheFindWay(Cache cache, int set, unsigned long long tag) {
+	int i, first, last;
+#if CACHE_PROBE_LANES > 1
+	unsigned int match;
+	int way;
+#endif
+
+	if(cache->wide_tags != NULL) {
+		return(cacheFindWideWay(cache, set, tag));
+	}
+
+	first = set * cache->nSA;
+	last = first + cache->nSA;
+	i = first;
+#if CACHE_PROBE_LANES > 1
+	for(; i + CACHE_PROBE_LANES <= last; i += CACHE_PROBE_LANES) {
+		match = cacheProbe(cache->tags + i, (unsigned int)tag);
+		while(match != 0) {
+			way = i + __builtin_ctz(match);
+			if(bitTest(cache->valid, way)) {
+				return(way);
+			}
+			match &= match - 1;
+		}
+	}
+#endif
+	for(; i < last; i++) {
+		if(cache->tags[i] == tag && bitTest(cache->valid, i)) {
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/* cacheVictim
+ *
+ * Picks the block of a set to replace: the first invalid way, else the
+ * one the replacement policy picks.
+ *
+ * @param	cache			Target cache struct
+ * @param	set				Cache set #
+ *
+ * @return	way				Block # to replace
+ */
+
+static inline int cacheVictim(Cache cache, int set) {
+	int i, first, last;
+
+	first = set * cache->nSA;
+	last = first + cache->nSA;
+	for(i = first; i < last; i++) {
+		if(!bitTest(cache->valid, i)) {
+			return(i);
+		}
+	}
+
+	return(first + policyVictim(cache->policy, set));
+}
+
+/* cacheSetTag
+ *
+ * Stores the tag of one block at the width the cache keeps its tags.
+ *
+ * @param	cache			Target cache struct
+ * @param	way				Block #
+ * @param	tag				Tag to store
+ *
+ * @return	void
+ */
+
+static inline void cacheSetTag(Cache cache, int way, unsigned long long tag) {
+	if(cache->wide_tags != NULL) {
+		cache->wide_tags[way] = tag;
+	}
+	else {
+		cache->tags[way] = (unsigned int)tag;
+	}
+}
+
+/* cacheFillWay
+ *
+ * Puts a block into a way, clean, and remembers what was evicted from
+ * it. Dirty evictions are counted as writes to main memory.
+ *
+ * @param	cache			Target cache struct
+ * @param	way				Block # to fill
+ * @param	set				Cache set # of the block
+ * @param	tag				Tag of the new block
+ *
+ * @return	void
+ */
+
+static inline void cacheFillWay(Cache cache, int way, int set, unsigned long long tag) {
+	cache->evicted = bitTest(cache->valid, way);
+	if(cache->evicted) {
+		cache->evict_address = (((cache->wide_tags != NULL) ? cache->wide_tags[way]
+			: cache->tags[way]) * (unsigned int)cache->set_count + (unsigned int)set)
+			* (unsigned int)cache->block_size;
+		cache->evict_dirty = bitTest(cache->dirty, way);
+		if(cache->evict_dirty) {
+			cache->writes++;
+		}
+	}
+	cacheSetTag(cache, way, tag);
+	bitSet(cache->valid, way);
+	bitClear(cache->dirty, way);
+}
+
+/* cacheLookup
+ *
+ * Shared body of every access to a cache. Splits the address
+ * into tag and set, looks for the tag in the set, and on a miss fills
+ * the first invalid block or the one the replacement policy picks. The
+ * policy is told about every hit and fill, and only ever looks at the
+ * set being accessed. Does no heap allocation.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ * @param	next_use		Index of the next access to the block, for OPT
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+static inline int cacheLookup(Cache cache, unsigned long long address, int write,
+	unsigned long long next_use) {
+	unsigned long long mm_block, tag;
+	int set, way, miss_class;
+	int hit;
+
+	cacheDecode(cache, address, &mm_block, &set, &tag);
+	way = cacheFindWay(cache, set, tag);
+	hit = (way >= 0);
+
+	/* A miss is compulsory the first time a block is used, and a
+	 * capacity miss if a fully associative cache would miss too */
+	if(cache->shadow != NULL) {
+		miss_class = shadowAccess(cache->shadow, mm_block);
+		if(!hit) {
+			if(miss_class == SHADOW_NEW) {
+				miss_class = CACHE_COMPULSORY;
+			}
+			else if(miss_class == SHADOW_MISS) {
+				miss_class = CACHE_CAPACITY;
+			}
+			else {
+				miss_class = CACHE_CONFLICT;
+			}
+			cache->classes[miss_class]++;
+			cache->set_classes[set * 3 + miss_class]++;
+		}
+	}
+
+	if(hit) {
+		cache->hits++;
+		cache->evicted = 0;
+		policyHit(cache->policy, set, way - set * cache->nSA, next_use);
+	}
+	else {
+		cache->misses++;
+		cache->reads++;
+		way = cacheVictim(cache, set);
+		cacheFillWay(cache, way, set, tag);
+		policyInsert(cache->policy, set, way - set * cache->nSA, next_use);
+	}
+	if(cache->profile != NULL) {
+		profileAccess(cache->profile, mm_block, set, way, hit, cache->evicted);
+	}
+	if(write) {
+		bitSet(cache->dirty, way);
+	}
+
+	return(hit);
+}
+
+/* cacheReadAddr
+ *
+ * Function that reads data from a cache using an integer address.
+ * Returns 0 on a miss or 1 on a hit.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+int cacheReadAddr(Cache cache, unsigned long long address) {
+	if(cache == NULL) {
+		fprintf(stderr, "\nError: Must supply a valid cache to read from.");
+		return(0);
+	}
+
+	return(cacheLookup(cache, address, 0, CACHE_NEVER));
+}
+
+/* cacheWriteAddr
+ *
+ * Function that writes data to a cache using an integer address.
+ * Returns 0 on a miss or 1 on a hit.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
 
-	/* Open the file for reading */
-	fgets(line, sizeof(line), file);
-	for(i = 0; i < sizeof(input); i++) {
-		if(line[i] == '\n') {
-			line[i] = '\0';
-		}
+int cacheWriteAddr(Cache cache, unsigned long long address) {
+	if(cache == NULL) {
+		fprintf(stderr, "\nError: Must supply a valid cache to write to.");
+		return(0);
 	}
-	addr_count = atoi(line);
 
-	/* Skip a line */
-	fgets(line, sizeof(line), file);
+	return(cacheLookup(cache, address, 1, CACHE_NEVER));
+}
 
-	cache = cacheCreate(cache_size, block_size, rep_policy, addr_count);
+/* cacheNextUse
+ *
+ * Works out, for every access of a trace, the index of the next access
+ * to the same main memory block, in one backward pass. This is what an
+ * OPT cache needs to know to pick its victims. Accesses that are not R
+ * or W never touch the cache and get CACHE_NEVER.
+ *
+ * @param	cache			Cache whose block size is used
+ * @param	addresses		Address of each access
+ * @param	modes			Mode of each access, R or W
+ * @param	count			Number of accesses
+ * @param	next_use		Array of count entries to fill in
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
 
-	cache->mm_size = mm_size;
-	cache->nSA = nSA;
-	cache->rep_policy = rep_policy;
-	cache->set_count = cache->block_count / cache->nSA;
+int cacheNextUse(Cache cache, const unsigned long long *addresses, const char *modes, long count,
+	unsigned long long *next_use) {
+	HashMap last;
+	unsigned long long *value;
+	long i;
+	int added;
 
-	cache->addr_size[0] = ceil_log2(cache->mm_size);
-	cache->addr_size[1] = ceil_log2(cache->block_size);
-	cache->addr_size[2] = ceil_log2((cache->cache_size / cache->block_size) / cache->nSA);
-	cache->addr_size[3] = ceil_log2(cache->mm_size) - cache->addr_size[1] - cache->addr_size[2];
-	n = cache->cache_size + cache->addr_size[3] + 1 + 1;
-
-	printf("\nSimulator Output:");
-	printf("\nTotal address lines required = %d", cache->addr_size[0]);
-	printf("\nNumber of bits for offset = %d", cache->addr_size[1]);
-	printf("\nNumber of bits for index = %d", cache->addr_size[2]);
-	printf("\nNumber of bits for tag = %d", cache->addr_size[3]);
-	printf("\nTotal cache size required = %d", n);
-
-	k = 0;
-	while(fgets(line, sizeof(line), file) != NULL) {
-		i = 0, j = 0;
-		cache->memory[k]->mode = line[i];
-		while(line[i] != ' ') {
-			i++;
-		}
-		while(line[i] != '\0') {
-			addr[j] = line[i];
-			i++;
-			j++;
-		}
-		addr[j-1] = '\0';
-		cache->memory[k]->address = atoi(addr);
-		k++;
+	last = hashMapCreate(1024);
+	if(last == NULL) {
+		return(0);
 	}
 
-	for(i = 0; i < cache->addr_count; i++) {
-		cache->memory[i]->mm_block = cache->memory[i]->address / block_size;
-		cache->memory[i]->cache_set = cache->memory[i]->mm_block % (cache->block_count / cache->nSA);
-		cache->memory[i]->cache_block_min = cache->memory[i]->cache_set * cache->nSA;
-		cache->memory[i]->cache_block_max = cache->memory[i]->cache_block_min + cache->nSA - 1;
-		if(cache->memory[i]->mode == 'R') {
-			cache->memory[i]->hit = cacheRead(cache, itob(cache->memory[i]->address));
-		}
-		else if(cache->memory[i]->mode == 'W') {
-			cache->memory[i]->hit = cacheWrite(cache, itob(cache->memory[i]->address));
-		}
-		else {
-			cache->memory[i]->hit = 0;
+	/* Walking backwards, the map holds the next index of each block */
+	for(i = count - 1; i >= 0; i--) {
+		if(modes[i] != 'R' && modes[i] != 'W') {
+			next_use[i] = CACHE_NEVER;
+			continue;
 		}
+		value = hashMapInsert(last, addresses[i] / (unsigned int)cache->block_size, &added);
+		next_use[i] = added ? CACHE_NEVER : *value;
+		*value = (unsigned long long)i;
 	}
+	hashMapDestroy(last);
 
-	for(i = cache->addr_count - 1; i > 0; i--) {
-		for(j = 0; j < i; j++) {
-			if(cache->memory[i]->mm_block == cache->memory[j]->mm_block) {
-				hits++;
-				j = i;
-			}
-		}
+	return(1);
+}
+
+/* cacheAccessNext
+ *
+ * Function that reads or writes a cache using an integer address, and
+ * tells the cache when the block will next be used. OPT caches must be
+ * accessed this way; the other policies ignore next_use. Returns 0 on
+ * a miss or 1 on a hit. The address must be below the main memory size.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ * @param	next_use		Index of the next access to the block, from
+ *							cacheNextUse, or CACHE_NEVER
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+int cacheAccessNext(Cache cache, unsigned long long address, int write, unsigned long long next_use) {
+	if(cache == NULL) {
+		fprintf(stderr, "\nError: Must supply a valid cache to access.");
+		return(0);
 	}
 
-	memoryPrint(cache);
+	return(cacheLookup(cache, address, write, next_use));
+}
 
-	rate = ((double)hits / (double)cache->addr_count) * 100;
-	printf("\n\nHighest possible hit rate = %d/%d = %f%%", hits, cache->addr_count, rate);
-	rate = ((double)cache->hits / (double)cache->addr_count) * 100;
-	printf("\nActual hit rate = %d/%d = %f%%", cache->hits, cache->addr_count, rate);
+/* cacheAccess
+ *
+ * Reads or writes a cache. OPT caches treat every block as never used
+ * again this way; use cacheNextUse and cacheAccessNext for those.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Main memory address, below mm_size
+ * @param	op				CACHE_READ or CACHE_WRITE
+ *
+ * @return	hit				1
+ * @return	miss			0
+ * @return	bad access		-1
+ */
 
-	printf("\n\nFinal status of the cache:");
+int cacheAccess(Cache cache, unsigned long long address, int op) {
+	if(cache == NULL || address >= (unsigned long long)cache->mm_size
+		|| (op != CACHE_READ && op != CACHE_WRITE)) {
+		return(-1);
+	}
 
-	cachePrint(cache);
+	return(cacheLookup(cache, address, op == CACHE_WRITE, CACHE_NEVER));
+}
 
-	/* Close the file and destroy the cache. */
-	fclose(file);
-	cacheDestroy(cache);
-	cache = NULL;
+/* cacheAccessBatch
+ *
+ * Reads or writes a cache once for each of an array of accesses, in
+ * order, with the checks made once per call where they can be. Stops
+ * at the first bad access, leaving the ones before it done.
+ *
+ * @param	cache			Target cache struct
+ * @param	addresses		Main memory address of each access
+ * @param	ops				CACHE_READ or CACHE_WRITE for each access,
+ *							or NULL for all reads
+ * @param	count			Number of accesses
+ * @param	hits			Filled in with 1 for each hit and 0 for each
+ *							miss, or NULL
+ *
+ * @return	success			# of hits
+ * @return	bad access		-1
+ */
 
-	do {
-		printf("\nContinue? (y/n): ");
-		fgets(input, sizeof(input), stdin);
-		for(i = 0; i < sizeof(input); i++) {
-			if(input[i] == '\n') {
-				input[i] = '\0';
-			}
-		}
-		valid = 0;
-		if(input[0] == 'y') {
-			goAgain = 1;
-			valid = 1;
-		}
-		else if(input[0] == 'n') {
-			goAgain = 0;
-			valid = 1;
-		}
-	} while(!valid);
+long cacheAccessBatch(Cache cache, const unsigned long long *addresses, const unsigned char *ops,
+	long count, unsigned char *hits) {
+	unsigned long long mm_size;
+	long i, total = 0;
+	int op, hit;
 
-} while(goAgain);
+	if(cache == NULL || count < 0 || (count > 0 && addresses == NULL)) {
+		return(-1);
+	}
 
-	system("clear");
-	printf("\n\n\n\nHave a nice day :)\n\n\n\n");
+	mm_size = (unsigned long long)cache->mm_size;
+	for(i = 0; i < count; i++) {
+		op = (ops != NULL) ? ops[i] : CACHE_READ;
+		if(addresses[i] >= mm_size || (op != CACHE_READ && op != CACHE_WRITE)) {
+			return(-1);
+		}
+		hit = cacheLookup(cache, addresses[i], op == CACHE_WRITE, CACHE_NEVER);
+		if(hits != NULL) {
+			hits[i] = (unsigned char)hit;
+		}
+		total += hit;
+	}
 
-	return(1);
+	return(total);
 }
 
-/* cacheCreate
+/* cacheFill
  *
- * Function to create a new cache struct. Returns the new struct on success
- * and NULL on failure.
+ * Puts a block into a cache without counting a hit or a miss, such as
+ * a victim moving down from the level above. If the block is already
+ * held it is only marked used, and dirty if asked.
  *
- * @param	cache_size		Size of cache in bytes
- * @param	block_size		Size of each block in bytes
- * @param	rep_policy		1 = LRU, 2 = FIFO
+ * @param	cache			Target cache struct
+ * @param	address			Any address inside the block
+ * @param	dirty			1 = The block is dirty
  *
- * @return	success			cache
- * @return	failure			NULL
+ * @return	void
  */
 
-Cache cacheCreate(int cache_size, int block_size, int rep_policy, int addr_count) {
-	Cache cache;
-	int i;
+void cacheFill(Cache cache, unsigned long long address, int dirty) {
+	unsigned long long mm_block, tag;
+	int set, way;
 
-	cache = (Cache) malloc(sizeof(struct Cache_));
-	if(cache == NULL) {
-		fprintf(stderr, "\nCould not allocate memory for cache.");
-		return NULL;
+	cacheDecode(cache, address, &mm_block, &set, &tag);
+	way = cacheFindWay(cache, set, tag);
+	if(way >= 0) {
+		cache->evicted = 0;
+		policyHit(cache->policy, set, way - set * cache->nSA, CACHE_NEVER);
 	}
+	else {
+		way = cacheVictim(cache, set);
+		cacheFillWay(cache, way, set, tag);
+		policyInsert(cache->policy, set, way - set * cache->nSA, CACHE_NEVER);
+	}
+	if(dirty) {
+		bitSet(cache->dirty, way);
+	}
+}
 
-	cache->hits = 0;
-	cache->misses = 0;
-	cache->reads = 0;
-	cache->writes = 0;
-
-	cache->cache_size = cache_size;
-	cache->block_size = block_size;
-	cache->rep_policy = rep_policy;
-	cache->addr_count = addr_count;
-
-	/* Calculate block_count */
-	cache->block_count = cache_size / block_size;
-
-	cache->block = (Block*) malloc(sizeof(Block) * cache->block_count);
-	assert(cache->block != NULL);
+/* cacheWarm
+ *
+ * Reads or writes a cache to keep its blocks and replacement state up
+ * to date, without counting anything: no hits, misses, or memory
+ * traffic, and no miss classes or profile. Runs accesses whose results
+ * are not wanted, such as those between the windows of a sampled run.
+ * OPT caches treat every block as never used again.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	void
+ */
 
-	cache->memory = (Memory*) malloc(sizeof(Memory) * cache->addr_count);
-	assert(cache->memory != NULL);
+void cacheWarm(Cache cache, unsigned long long address, int write) {
+	unsigned long long mm_block, tag;
+	int set, way;
 
-	/* Insert blocks where valid = 0 */
-	for(i = 0; i < cache->block_count; i++) {
-		cache->block[i] = (Block) malloc(sizeof(struct Block_));
-		assert(cache->block[i] != NULL);
-		cache->block[i]->access_count = 0;
-		cache->block[i]->time_count = 0;
-		cache->block[i]->valid = 0;
-		cache->block[i]->dirty = -1;
-		cache->block[i]->tag = NULL;
-		cache->block[i]->data = -1;
+	cacheDecode(cache, address, &mm_block, &set, &tag);
+	way = cacheFindWay(cache, set, tag);
+	if(way >= 0) {
+		policyHit(cache->policy, set, way - set * cache->nSA, CACHE_NEVER);
+	}
+	else {
+		way = cacheVictim(cache, set);
+		cacheSetTag(cache, way, tag);
+		bitSet(cache->valid, way);
+		bitClear(cache->dirty, way);
+		policyInsert(cache->policy, set, way - set * cache->nSA, CACHE_NEVER);
+	}
+	cache->evicted = 0;
+	if(write) {
+		bitSet(cache->dirty, way);
 	}
+}
+
+/* cacheInvalidate
+ *
+ * Drops a block from a cache, if it is held, without counting a hit,
+ * a miss, or a write. Does not change what cacheEvicted reports.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Any address inside the block
+ *
+ * @return	not held		0
+ * @return	clean			1
+ * @return	dirty			2
+ */
 
-	for(i = 0; i < cache->addr_count; i++) {
-		cache->memory[i] = (Memory) malloc(sizeof(struct Memory_));
-		assert(cache->memory[i] != NULL);
+int cacheInvalidate(Cache cache, unsigned long long address) {
+	unsigned long long mm_block, tag;
+	int set, way;
 
-		cache->memory[i]->mode = 'R';
-		cache->memory[i]->address = 0;
-		cache->memory[i]->cache_block_max = 0;
-		cache->memory[i]->cache_block_min = 0;
-		cache->memory[i]->cache_set = 0;
-		cache->memory[i]->mm_block = 0;
-		cache->memory[i]->hit = 0;
+	cacheDecode(cache, address, &mm_block, &set, &tag);
+	way = cacheFindWay(cache, set, tag);
+	if(way < 0) {
+		return(0);
 	}
+	bitClear(cache->valid, way);
 
-	return(cache);
+	return(bitTest(cache->dirty, way) ? 2 : 1);
 }
 
-/* cacheDestroy
- * 
- * Function that destroys a created cache. Frees all allocated memory. If 
- * you pass in NULL, nothing happens. So make sure to set your cache = NULL
- * after you destroy it to prevent a double free.
+/* cacheEvicted
  *
- * @param	cache			Target cache object to be destroyed
+ * Tells whether the last access or fill of a cache evicted a valid
+ * block, and which one.
  *
- * @return	void
+ * @param	cache			Target cache struct
+ * @param	address			Set to the first address of the evicted block
+ * @param	dirty			Set to 1 if the evicted block was dirty
+ *
+ * @return	evicted			1
+ * @return	nothing evicted	0
  */
 
-void cacheDestroy(Cache cache) {
-	int i;
-
-	if(cache != NULL) {
-		for(i = 0; i < cache->block_count; i++) {
-			if(cache->block[i]->tag != NULL) {
-				free(cache->block[i]->tag);
-			}
-			free(cache->block[i]);
-		}
-		free(cache->block);
-		free(cache->memory);
-		free(cache);
+int cacheEvicted(Cache cache, unsigned long long *address, int *dirty) {
+	if(!cache->evicted) {
+		return(0);
 	}
+	*address = cache->evict_address;
+	*dirty = cache->evict_dirty;
 
-	return;
+	return(1);
 }
 
 /* cacheRead
@@ -466,114 +3350,18 @@ void cacheDestroy(Cache cache) {
  */
 
 int cacheRead(Cache cache, char *address) {
-	char *tag, *index, *offset, *data;
-	int i, j;
-	int hit = 0;
-	int time = -1;
-	Block block;
-
-	/* Validate inputs */
-	if(cache == NULL) {
-		fprintf(stderr, "\nError: Must supply a valid cache to write to.");
-		return(0);
-	}
 	if(address == NULL) {
 		fprintf(stderr, "\nError: Must supply a valid memory address.");
 		return(0);
 	}
 
-	/* Get tag, index, and offset */
-	i = strlen(address) - cache->addr_size[0];
-
-	tag = (char *) malloc(sizeof(char) * (cache->addr_size[3] + 2));
-	assert(tag != NULL);
-	tag[cache->addr_size[3]] = '\0';
-	for(j = 0; j < cache->addr_size[3]; j++) {
-		tag[j] = address[i];
-		i++;
-	}
-
-	index = (char *) malloc(sizeof(char) * (cache->addr_size[2] + 2));
-	assert(index != NULL);
-	index[cache->addr_size[2]] = '\0';
-	for(j = 0; j < cache->addr_size[2]; j++) {
-		index[j] = address[i];
-		i++;
-	}
-
-	offset = (char *) malloc(sizeof(char) * (cache->addr_size[1] + 2));
-	assert(offset != NULL);
-	offset[cache->addr_size[1]] = '\0';
-	for(j = 0; j < cache->addr_size[1]; j++) {
-		offset[j] = address[i];
-		i++;
-	}
-
-	/* Find cache block for reading */
-	for(i = 0; i < cache->block_count; i++) {
-		if((i >= btoi(index) * cache->nSA)&&(i < (btoi(index) + 1) * cache->nSA)) {
-			if(cache->block[i]->valid == 0) {
-				block = cache->block[i];
-				block->tag = tag;
-				i = cache->block_count;
-			}
-			else if(cache->rep_policy == 1) {
-				if(cache->block[i]->time_count > time) {
-					block = cache->block[i];
-					time = cache->block[i]->time_count;
-				}
-			}
-			else if(cache->rep_policy == 2) {
-				if(cache->block[i]->time_count > time) {
-					block = cache->block[i];
-					time = cache->block[i]->time_count;
-				}
-			}
-		}
-	}
-
-	data = (char *) malloc(sizeof(char) * (cache->addr_size[2] + cache->addr_size[3] + 1));
-	j = 0;
-	for(i = 0; i < cache->addr_size[3]; i++) {
-		data[j] = tag[i];
-		j++;
-	}
-	for(i = 0; i < cache->addr_size[2]; i++) {
-		data[j] = index[i];
-		j++;
-	}
-
-	block->data = btoi(data);
-	printf("\n%s", tag);
-	if(block->valid == 1 && strcmp(block->tag, tag) == 0) {
-		hit = 1;
-		cache->hits++;
-	}
-	else {
-		cache->misses++;
-		cache->reads++;
-	}
-	block->tag = tag;
-	block->dirty = 0;
-	block->valid = 1;
-
-	for(i = 0; i < cache->block_count; i++) {
-		cache->block[i]->time_count++;
-	}
-	block->time_count = 0;
-
-	free(offset);
-	free(index);
-	free(data);
-
-	return(hit);
+	return(cacheReadAddr(cache, btoi(address)));
 }
 
 /* cacheWrite
  *
  * Function that writes data to the cache. Returns 0 on failure or
- * 1 on success. Frees any old tags that already existed in the
- * target slot.
+ * 1 on success.
  *
  * @param	cache			Target cache struct
  * @param	address			Binary address
@@ -583,109 +3371,12 @@ int cacheRead(Cache cache, char *address) {
  */
 
 int cacheWrite(Cache cache, char *address) {
-	char *tag, *index, *offset, *data;
-	int i, j;
-	int hit = 0;
-	int time = -1;
-	Block block;
-	/* Validate inputs */
-	if(cache == NULL) {
-		fprintf(stderr, "\nError: Must supply a valid cache to write to.");
-		return(0);
-	}
 	if(address == NULL) {
 		fprintf(stderr, "\nError: Must supply a valid memory address.");
 		return(0);
 	}
 
-	/* Get tag, index, and offset */
-	i = strlen(address) - cache->addr_size[0];
-
-	tag = (char *) malloc(sizeof(char) * (cache->addr_size[3] + 2));
-	assert(tag != NULL);
-	tag[cache->addr_size[3]] = '\0';
-	for(j = 0; j < cache->addr_size[3]; j++) {
-		tag[j] = address[i];
-		i++;
-	}
-
-	index = (char *) malloc(sizeof(char) * (cache->addr_size[2] + 2));
-	assert(index != NULL);
-	index[cache->addr_size[2]] = '\0';
-	for(j = 0; j < cache->addr_size[2]; j++) {
-		index[j] = address[i];
-		i++;
-	}
-
-	offset = (char *) malloc(sizeof(char) * (cache->addr_size[1] + 2));
-	assert(offset != NULL);
-	offset[cache->addr_size[1]] = '\0';
-	for(j = 0; j < cache->addr_size[1]; j++) {
-		offset[j] = address[i];
-		i++;
-	}
-
-	/* Find cache block for writing */
-	for(i = 0; i < cache->block_count; i++) {
-		if((i >= btoi(index) * cache->nSA)&&(i < (btoi(index) + 1) * cache->nSA)) {
-			if(cache->block[i]->valid == 0) {
-				block = cache->block[i];
-				block->tag = tag;
-				i = cache->block_count;
-			}
-			else if(cache->rep_policy == 1) {
-				if(cache->block[i]->time_count > time) {
-					block = cache->block[i];
-					time = cache->block[i]->time_count;
-				}
-			}
-			else if(cache->rep_policy == 2) {
-				if(cache->block[i]->time_count > time) {
-					block = cache->block[i];
-					time = cache->block[i]->time_count;
-				}
-			}
-		}
-	}
-
-	data = (char *) malloc(sizeof(char) * (cache->addr_size[2] + cache->addr_size[3] + 1));
-	j = 0;
-	for(i = 0; i < cache->addr_size[3]; i++) {
-		data[j] = tag[i];
-		j++;
-	}
-	for(i = 0; i < cache->addr_size[2]; i++) {
-		data[j] = index[i];
-		j++;
-	}
-
-	block->data = btoi(data);
-	printf("\n%s", tag);
-	if(block->valid == 1 && strcmp(block->tag, tag) == 0) {
-		hit = 1;
-		cache->hits++;
-	}
-	else {
-		cache->misses++;
-		cache->reads++;
-		if(block->dirty == 1) {
-			cache->writes++;
-		}
-	}
-	block->tag = tag;
-	block->dirty = 1;
-	block->valid = 1;
-
-	for(i = 0; i < cache->block_count; i++) {
-		cache->block[i]->time_count++;
-	}
-	block->time_count = 0;
-
-	free(offset);
-	free(index);
-	free(data);
-
-	return(hit);
+	return(cacheWriteAddr(cache, btoi(address)));
 }
 
 /* cachePrint
@@ -699,6 +3390,7 @@ int cacheWrite(Cache cache, char *address) {
  */
 
 void cachePrint(Cache cache) {
+	unsigned long long tag;
 	int i, j;
 	//char tag[cache->addr_size[3]];
 
@@ -706,27 +3398,24 @@ void cachePrint(Cache cache) {
 	printf("\n****************************************************************");
 	for(i = 0; i < cache->block_count; i++) {
 		printf("\n %d", i);
-		if(cache->block[i]->dirty == -1) {
+		if(!bitTest(cache->valid, i)) {
 			printf("\t\tx");
 		}
 		else {
-			printf("\t\t%d", cache->block[i]->dirty);
+			printf("\t\t%d", bitTest(cache->dirty, i));
 		}
-		printf("\t\t%d", cache->block[i]->valid);
+		printf("\t\t%d", bitTest(cache->valid, i));
 		printf("\t\t");
-		if(cache->block[i]->tag == NULL) {
+		if(!bitTest(cache->valid, i)) {
 			for(j = 0; j < cache->addr_size[3]; j++) {
 				printf("x");
 			}
-		}
-		else {
-			printf("%s", cache->block[i]->tag);
-		}
-		if(cache->block[i]->data == -1) {
 			printf("\tX");
 		}
 		else {
-			printf("\tmm blk #%d", cache->block[i]->data);
+			tag = (cache->wide_tags != NULL) ? cache->wide_tags[i] : cache->tags[i];
+			tagPrint(cache, tag);
+			printf("\tmm blk #%llu", tag * (unsigned int)cache->set_count + (unsigned int)(i / cache->nSA));
 		}
 	}
 }
@@ -742,9 +3431,10 @@ void cachePrint(Cache cache) {
  * @return	int				User-inputted integer
  */
 
-int getUserInt(char *prompt, int max_val, int min_val) {
+long long getUserInt(char *prompt, long long max_val, long long min_val) {
 	char input[128];
-	int input_int, valid;
+	long long input_int;
+	int valid;
 
 	do {
 		printf(prompt);
@@ -755,9 +3445,9 @@ int getUserInt(char *prompt, int max_val, int min_val) {
 			}
 		}
 		valid = 1;
-		input_int = atoi(input);
+		input_int = atoll(input);
 		if((input_int < min_val)||(input_int > max_val)) {
-			printf("Error: Value must be between %d and %d", min_val, max_val);
+			printf("Error: Value must be between %lld and %lld", min_val, max_val);
 			valid = 0;
 		}
 	} while(!valid);
@@ -772,24 +3462,25 @@ int getUserInt(char *prompt, int max_val, int min_val) {
  * @param	cache_size		Size of cache in bytes
  * @param	block_size		Size of each block in bytes
  * @param	nSA				Set-Associativity
- * @param	rep_policy		1 = LRU, 2 = FIFO
+ * @param	rep_policy		One of the CACHE_ policy numbers
  * @param	filename		Name of input file
  *
  * @return	void
  */
 
-void inputPrint(int mm_size, int cache_size, int block_size, int nSA, int rep_policy, char *filename) {
-	system("clear");
+void inputPrint(long long mm_size, long long cache_size, int block_size, int nSA, int rep_policy,
+	char *filename) {
+	screenClear();
 
 	printf("\nMain Memory Size (bytes): ");
 	if(mm_size)
-		printf("%d", mm_size);
+		printf("%lld", mm_size);
 	else
 		printf("N/A");
 
 	printf("\nCache Memory Size (bytes): ");
 	if(cache_size)
-		printf("%d", cache_size);
+		printf("%lld", cache_size);
 	else
 		printf("N/A");
 
@@ -805,51 +3496,50 @@ void inputPrint(int mm_size, int cache_size, int block_size, int nSA, int rep_po
 	else
 		printf("N/A");
 
-	printf("\nReplacement Policy: ");
-	if(rep_policy == 1)
-		printf("LRU");
-	else if(rep_policy == 2)
-		printf("FIFO");
-	else
-		printf("N/A");
+	printf("\nReplacement Policy: %s", cachePolicyName(rep_policy));
 	printf("\nInput File: %s\n", filename);
 
 }
 
+/* memoryPrintHeader
+ *
+ * Prints the column headings for memoryPrint.
+ *
+ * @return	void
+ */
+
+void memoryPrintHeader(void) {
+	printf("\n\n mm address\tmm blk #\tcm set #\tcm blk #\thit/miss");
+	printf("\n************************************************************************");
+}
+
 /* memoryPrint
  *
- * Prints out the memory addresses used and their
+ * Prints out one memory address used and its
  * respective mm block #, cache set #, cache block #s,
  * and hit status.
  *
- * @param	cache			Target cache struct
+ * @param	cache			Cache the access went to
+ * @param	memory			Memory access to print
  *
  * @return	void
  */
 
-void memoryPrint(Cache cache) {
-	int i;
-	Memory memory;
-
-	printf("\n\n mm address\tmm blk #\tcm set #\tcm blk #\thit/miss");
-	printf("\n************************************************************************");
-	for(i = 0; i < cache->addr_count; i++) {
-		memory = cache->memory[i];
-		printf("\n %d\t", memory->address);
-		printf("\t%d", memory->mm_block);
-		printf("\t\t%d", memory->cache_set);
-		if(cache->nSA > 1) {
-			printf("\t\t%d - %d", memory->cache_block_min, memory->cache_block_max);
-		}
-		else {
-			printf("\t\t%d", memory->cache_block_min);
-		}
-		if(memory->hit) {
-			printf("\t\thit");
-		}
-		else {
-			printf("\t\tmiss");
-		}
+void memoryPrint(Cache cache, Memory memory) {
+	printf("\n %llu\t", memory->address);
+	printf("\t%llu", memory->mm_block);
+	printf("\t\t%d", memory->cache_set);
+	if(cache->nSA > 1) {
+		printf("\t\t%d - %d", memory->cache_block_min, memory->cache_block_max);
+	}
+	else {
+		printf("\t\t%d", memory->cache_block_min);
+	}
+	if(memory->hit) {
+		printf("\t\thit");
+	}
+	else {
+		printf("\t\tmiss");
 	}
 }
 
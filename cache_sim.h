@@ -8,10 +8,111 @@
  *  each memory address and the final status of the cache.
  */
 
+#ifndef CACHE_SIM_H
+#define CACHE_SIM_H
+
+#include "profile.h"
+
 /* Typedefs */
-typedef struct Block_* Block;
 typedef struct Cache_* Cache;
 typedef struct Memory_* Memory;
+typedef struct CacheStats_ CacheStats;
+typedef struct CacheConfig_ CacheConfig;
+
+/* Replacement policies */
+#define CACHE_LRU		1
+#define CACHE_FIFO		2
+#define CACHE_OPT		3
+#define CACHE_RANDOM	4
+#define CACHE_PLRU		5
+#define CACHE_LFU		6
+#define CACHE_SRRIP		7
+#define CACHE_BRRIP		8
+
+/* Access operations */
+#define CACHE_READ		0
+#define CACHE_WRITE		1
+
+/* Miss classes */
+#define CACHE_COMPULSORY	0
+#define CACHE_CAPACITY		1
+#define CACHE_CONFLICT		2
+
+/* Next use of a block that is never used again */
+#define CACHE_NEVER		(~0ull)
+
+/* CacheStats
+ *
+ * Copy of the counters of a cache, filled in by cacheGetStats.
+ *
+ * @param	hits			# of cache accesses that hit valid data
+ * @param	misses			# of cache accesses that missed valid data
+ * @param	reads			# of reads from main memory
+ * @param	writes			# of writes to main memory
+ * @param	compulsory		# of misses to blocks never used before
+ * @param	capacity		# of misses a fully associative cache also has
+ * @param	conflict		# of other misses, caused by set mapping
+ */
+
+struct CacheStats_ {
+	long long hits;
+	long long misses;
+	long long reads;
+	long long writes;
+	long long compulsory;
+	long long capacity;
+	long long conflict;
+};
+
+/* CacheConfig
+ *
+ * Everything cacheCreateConfig needs to build a cache.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	classify		1 = Classify misses, as cacheSetClassify
+ * @param	profile			1 = Keep a profile, as cacheSetProfile
+ */
+
+struct CacheConfig_ {
+	long long mm_size;
+	long long cache_size;
+	int block_size;
+	int nSA;
+	int rep_policy;
+	int classify;
+	int profile;
+};
+
+/* cacheConfigCheck
+ *
+ * Checks that a config describes a cache that can be built.
+ *
+ * @param	config			Config to check
+ *
+ * @return	valid			NULL
+ * @return	invalid			Reason the config is invalid
+ */
+
+const char *cacheConfigCheck(const CacheConfig *config);
+
+/* cacheCreateConfig
+ *
+ * Creates a cache from a config, with its geometry set and its miss
+ * classification and profile turned on as asked, ready for accesses.
+ * Caches share no state, so each one can be used from its own thread.
+ * Returns NULL if the config is invalid or memory runs out.
+ *
+ * @param	config			What to build
+ *
+ * @return	success			cache
+ * @return	failure			NULL
+ */
+
+Cache cacheCreateConfig(const CacheConfig *config);
 
 /* cacheCreate
  *
@@ -20,13 +121,13 @@ typedef struct Memory_* Memory;
  *
  * @param	cache_size		Size of cache in bytes
  * @param	block_size		Size of each block in bytes
- * @param	rep_policy		1 = LRU, 2 = FIFO
+ * @param	rep_policy		One of the CACHE_ policy numbers
  *
  * @return	success			cache
  * @return	failure			NULL
  */
  
-Cache cacheCreate(int cache_size, int block_size, int rep_policy, int addr_count);
+Cache cacheCreate(long long cache_size, int block_size, int rep_policy);
 
 /* cacheDestroy
  * 
@@ -41,6 +142,345 @@ Cache cacheCreate(int cache_size, int block_size, int rep_policy, int addr_count
  
 void cacheDestroy(Cache cache);
 
+/* cacheSetGeometry
+ *
+ * Sets the main memory size and set-associativity of a created cache
+ * and works out the number of sets and the width of each address
+ * field. Tags are kept in 32 bits each unless the largest tag of main
+ * memory needs more. Must be called before any reads or writes.
+ *
+ * @param	cache			Target cache struct
+ * @param	mm_size			Size of main memory in bytes
+ * @param	nSA				Set-Associativity
+ *
+ * @return	void
+ */
+
+void cacheSetGeometry(Cache cache, long long mm_size, int nSA);
+
+/* cacheSetClassify
+ *
+ * Turns miss classification on or off. When on, every miss is counted
+ * as compulsory, capacity, or conflict, overall and for each set, with
+ * the help of a fully associative LRU shadow cache of the same size.
+ * Must be called after cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	classify		0 = Off, 1 = Classify misses
+ *
+ * @return	void
+ */
+
+void cacheSetClassify(Cache cache, int classify);
+
+/* cacheSetProfile
+ *
+ * Turns detailed statistics on or off. When on, every access is
+ * counted in a Profile of per-set counters, eviction age and reuse
+ * distance histograms, and per-block use counts. Must be called after
+ * cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	profile			0 = Off, 1 = Keep a profile
+ *
+ * @return	void
+ */
+
+void cacheSetProfile(Cache cache, int profile);
+
+/* cacheGetProfile
+ *
+ * Gives the profile of a cache.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	profile			Profile, or NULL when it is turned off
+ */
+
+Profile cacheGetProfile(Cache cache);
+
+/* cacheSetShard
+ *
+ * Marks a cache as holding only sets shard, shard + shards, and so on
+ * of a bigger cache, as the set-sharded engine builds them. Per-set
+ * random state is then seeded from the set # in the bigger cache, so
+ * a policy like Random picks the same victims in either. Must be
+ * called after cacheSetGeometry and before any accesses.
+ *
+ * @param	cache			Target cache struct
+ * @param	shard			Set # of set 0 in the bigger cache
+ * @param	shards			Number of caches the bigger one is split into
+ *
+ * @return	void
+ */
+
+void cacheSetShard(Cache cache, int shard, int shards);
+
+/* cacheFootprint
+ *
+ * Works out how many bytes of host memory the block state of a cache
+ * takes up. The cache struct itself and the memory records are not
+ * counted.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	bytes			Bytes used by the block arrays
+ */
+
+long cacheFootprint(Cache cache);
+
+/* cachePolicyName
+ *
+ * Gives the name of a replacement policy.
+ *
+ * @param	rep_policy		Replacement policy number
+ *
+ * @return	known			Name of the policy, such as "LRU"
+ * @return	unknown			"N/A"
+ */
+
+const char *cachePolicyName(int rep_policy);
+
+/* cacheGetStats
+ *
+ * Copies the counters of a cache.
+ *
+ * @param	cache			Target cache struct
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void cacheGetStats(Cache cache, CacheStats *stats);
+
+/* cacheResetStats
+ *
+ * Zeroes the hit, miss, and memory traffic counters of a cache and its
+ * miss classes, leaving its blocks and replacement state as they are.
+ *
+ * @param	cache			Target cache struct
+ *
+ * @return	void
+ */
+
+void cacheResetStats(Cache cache);
+
+/* cacheSave
+ *
+ * Writes the whole state of a cache to a file, so that a run can go on
+ * from it later: its geometry, policy, counters, tags, valid and dirty
+ * bits, and replacement metadata, as they are held in memory. Miss
+ * classes per set and the profile are not saved.
+ *
+ * @param	cache			Target cache struct
+ * @param	file			File to write to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int cacheSave(Cache cache, FILE *file);
+
+/* cacheRestore
+ *
+ * Puts back the state written by cacheSave into a cache built with
+ * the same main memory size, cache size, block size, and associativity.
+ * Must be called after cacheSetGeometry and before any accesses. If the
+ * cache uses another policy, the blocks and counters are still put
+ * back, but its replacement metadata starts out fresh, so many policies
+ * can start from one warm cache.
+ *
+ * @param	cache			Target cache struct
+ * @param	data			Saved state, such as a mapped file
+ * @param	size			Bytes of saved state
+ *
+ * @return	success			1
+ * @return	mismatch		0
+ */
+
+int cacheRestore(Cache cache, const void *data, long size);
+
+/* cacheGetSetMisses
+ *
+ * Gives the number of misses of one class in one set. Only counted
+ * while miss classification is on.
+ *
+ * @param	cache			Target cache struct
+ * @param	set				Cache set #
+ * @param	miss_class		CACHE_COMPULSORY, CACHE_CAPACITY, or CACHE_CONFLICT
+ *
+ * @return	misses			# of misses of that class in the set
+ */
+
+long long cacheGetSetMisses(Cache cache, int set, int miss_class);
+
+/* cacheReadAddr
+ *
+ * Function that reads data from a cache using an integer address.
+ * Returns 0 on a miss or 1 on a hit. Does no heap allocation.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+int cacheReadAddr(Cache cache, unsigned long long address);
+
+/* cacheWriteAddr
+ *
+ * Function that writes data to a cache using an integer address.
+ * Returns 0 on a miss or 1 on a hit. Does no heap allocation.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+int cacheWriteAddr(Cache cache, unsigned long long address);
+
+/* cacheNextUse
+ *
+ * Works out, for every access of a trace, the index of the next access
+ * to the same main memory block, in one backward pass. This is what an
+ * OPT cache needs to know to pick its victims. Accesses that are not R
+ * or W never touch the cache and get CACHE_NEVER.
+ *
+ * @param	cache			Cache whose block size is used
+ * @param	addresses		Address of each access
+ * @param	modes			Mode of each access, R or W
+ * @param	count			Number of accesses
+ * @param	next_use		Array of count entries to fill in
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int cacheNextUse(Cache cache, const unsigned long long *addresses, const char *modes, long count,
+	unsigned long long *next_use);
+
+/* cacheAccessNext
+ *
+ * Function that reads or writes a cache using an integer address, and
+ * tells the cache when the block will next be used. OPT caches must be
+ * accessed this way; the other policies ignore next_use. Returns 0 on
+ * a miss or 1 on a hit. The address must be below the main memory size.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ * @param	next_use		Index of the next access to the block, from
+ *							cacheNextUse, or CACHE_NEVER
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+int cacheAccessNext(Cache cache, unsigned long long address, int write,
+	unsigned long long next_use);
+
+/* cacheAccess
+ *
+ * Reads or writes a cache. OPT caches treat every block as never used
+ * again this way; use cacheNextUse and cacheAccessNext for those.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Main memory address, below mm_size
+ * @param	op				CACHE_READ or CACHE_WRITE
+ *
+ * @return	hit				1
+ * @return	miss			0
+ * @return	bad access		-1
+ */
+
+int cacheAccess(Cache cache, unsigned long long address, int op);
+
+/* cacheAccessBatch
+ *
+ * Reads or writes a cache once for each of an array of accesses, in
+ * order, with the checks made once per call where they can be. Stops
+ * at the first bad access, leaving the ones before it done.
+ *
+ * @param	cache			Target cache struct
+ * @param	addresses		Main memory address of each access
+ * @param	ops				CACHE_READ or CACHE_WRITE for each access,
+ *							or NULL for all reads
+ * @param	count			Number of accesses
+ * @param	hits			Filled in with 1 for each hit and 0 for each
+ *							miss, or NULL
+ *
+ * @return	success			# of hits
+ * @return	bad access		-1
+ */
+
+long cacheAccessBatch(Cache cache, const unsigned long long *addresses, const unsigned char *ops,
+	long count, unsigned char *hits);
+
+/* cacheFill
+ *
+ * Puts a block into a cache without counting a hit or a miss, such as
+ * a victim moving down from the level above. If the block is already
+ * held it is only marked used, and dirty if asked.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Any address inside the block
+ * @param	dirty			1 = The block is dirty
+ *
+ * @return	void
+ */
+
+void cacheFill(Cache cache, unsigned long long address, int dirty);
+
+/* cacheWarm
+ *
+ * Reads or writes a cache to keep its blocks and replacement state up
+ * to date, without counting anything: no hits, misses, or memory
+ * traffic, and no miss classes or profile. Runs accesses whose results
+ * are not wanted, such as those between the windows of a sampled run.
+ * OPT caches treat every block as never used again.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	void
+ */
+
+void cacheWarm(Cache cache, unsigned long long address, int write);
+
+/* cacheInvalidate
+ *
+ * Drops a block from a cache, if it is held, without counting a hit,
+ * a miss, or a write. Does not change what cacheEvicted reports.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Any address inside the block
+ *
+ * @return	not held		0
+ * @return	clean			1
+ * @return	dirty			2
+ */
+
+int cacheInvalidate(Cache cache, unsigned long long address);
+
+/* cacheEvicted
+ *
+ * Tells whether the last access or fill of a cache evicted a valid
+ * block, and which one.
+ *
+ * @param	cache			Target cache struct
+ * @param	address			Set to the first address of the evicted block
+ * @param	dirty			Set to 1 if the evicted block was dirty
+ *
+ * @return	evicted			1
+ * @return	nothing evicted	0
+ */
+
+int cacheEvicted(Cache cache, unsigned long long *address, int *dirty);
+
 /* cacheRead
  *
  * Function that reads data from a cache. Returns 0 on failure
@@ -58,8 +498,7 @@ int cacheRead(Cache cache, char *address);
 /* cacheWrite
  *
  * Function that writes data to the cache. Returns 0 on failure or
- * 1 on success. Frees any old tags that already existed in the
- * target slot.
+ * 1 on success.
  *
  * @param	cache			Target cache struct
  * @param	address			Binary address
@@ -93,7 +532,7 @@ void cachePrint(Cache cache);
  * @return	int				User-inputted integer
  */
 
-int getUserInt(char *prompt, int max_val, int min_val);
+long long getUserInt(char *prompt, long long max_val, long long min_val);
 
 /* inputPrint
  *
@@ -102,25 +541,38 @@ int getUserInt(char *prompt, int max_val, int min_val);
  * @param	cache_size		Size of cache in bytes
  * @param	block_size		Size of each block in bytes
  * @param	nSA				Set-Associativity
- * @param	rep_policy		1 = LRU, 2 = FIFO
+ * @param	rep_policy		One of the CACHE_ policy numbers
  * @param	filename		Name of input file
  *
  * @return	void
  */
 
-void inputPrint(int mm_size, int cache_size, int block_size, int nSA, int rep_policy, char *filename);
+void inputPrint(long long mm_size, long long cache_size, int block_size, int nSA, int rep_policy,
+	char *filename);
+
+/* memoryPrintHeader
+ *
+ * Prints the column headings for memoryPrint.
+ *
+ * @return	void
+ */
+
+void memoryPrintHeader(void);
 
 /* memoryPrint
  *
- * Prints out the memory addresses used and their
+ * Prints out one memory address used and its
  * respective mm block #, cache set #, cache block #s,
  * and hit status.
  *
- * @param	cache			Target cache struct
+ * @param	cache			Cache the access went to
+ * @param	memory			Memory access to print
  *
  * @return	void
  */
 
-void memoryPrint(Cache cache);
+void memoryPrint(Cache cache, Memory memory);
+
+#endif
 
 /* END OF FILE */
@@ -0,0 +1,206 @@
+/* Description: Checkpoints of a cache. Saved state is written straight
+ *  from the arrays of the cache and restored with plain copies, so a
+ *  mapped checkpoint is restored without being parsed.
+ */
+
+/* Libraries */
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+/* Checkpoint header: magic, version, and three reserved bytes */
+static const char checkpoint_magic[4] = {'C', 'S', 'C', 'K'};
+#define CHECKPOINT_VERSION		2
+#define CHECKPOINT_HEADER_SIZE	8
+
+/* Reads back the same only in the byte order it was written in */
+#define CHECKPOINT_ORDER		0x0102030405060708ull
+
+/* Bytes before the saved cache: header, order mark, and position */
+#define CHECKPOINT_PREFIX_SIZE	(CHECKPOINT_HEADER_SIZE + 16)
+
+/* Structs */
+
+/* Checkpoint
+ *
+ * @param	mapped			1 = File is mapped, 0 = Read into buffer
+ * @param	buffer			Start of the mapping or the read buffer
+ * @param	size			Bytes mapped or allocated for buffer
+ * @param	position		Trace position the checkpoint was taken at
+ */
+
+struct Checkpoint_ {
+	int mapped;
+	unsigned char *buffer;
+	size_t size;
+	unsigned long long position;
+};
+
+/* checkpointWrite
+ *
+ * Writes a checkpoint of a cache.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	cache			Cache to save
+ * @param	position		# of trace accesses the cache has seen
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int checkpointWrite(const char *filename, Cache cache, unsigned long long position) {
+	char header[CHECKPOINT_HEADER_SIZE] = {0};
+	unsigned long long prefix[2];
+	FILE *file;
+	int ok;
+
+	file = fopen(filename, "wb");
+	if(file == NULL) {
+		return(0);
+	}
+
+	memcpy(header, checkpoint_magic, sizeof(checkpoint_magic));
+	header[4] = CHECKPOINT_VERSION;
+	prefix[0] = CHECKPOINT_ORDER;
+	prefix[1] = position;
+	ok = (fwrite(header, sizeof(header), 1, file) == 1)
+		&& (fwrite(prefix, sizeof(prefix), 1, file) == 1)
+		&& cacheSave(cache, file);
+
+	return((fclose(file) == 0) && ok);
+}
+
+/* checkpointOpen
+ *
+ * Opens a checkpoint for restoring, either mapped or read into memory.
+ * One open checkpoint can restore any number of caches, from any
+ * number of threads. Returns NULL if the file cannot be read or is not
+ * a checkpoint.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	map				1 = Map the file, 0 = Read it into memory
+ *
+ * @return	success			checkpoint
+ * @return	failure			NULL
+ */
+
+Checkpoint checkpointOpen(const char *filename, int map) {
+	Checkpoint checkpoint;
+	unsigned long long prefix[2];
+	struct stat st;
+	ssize_t got;
+	size_t done;
+	void *mapping;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if(fd < 0) {
+		return NULL;
+	}
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < CHECKPOINT_PREFIX_SIZE) {
+		close(fd);
+		return NULL;
+	}
+
+	checkpoint = (Checkpoint) malloc(sizeof(struct Checkpoint_));
+	if(checkpoint == NULL) {
+		close(fd);
+		return NULL;
+	}
+	checkpoint->mapped = 0;
+	checkpoint->size = (size_t)st.st_size;
+
+	/* Map the file, otherwise fall back to reading it whole */
+	if(map) {
+		mapping = mmap(NULL, checkpoint->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapping != MAP_FAILED) {
+			checkpoint->mapped = 1;
+			checkpoint->buffer = (unsigned char *) mapping;
+		}
+	}
+	if(!checkpoint->mapped) {
+		checkpoint->buffer = (unsigned char *) malloc(checkpoint->size);
+		for(done = 0; checkpoint->buffer != NULL && done < checkpoint->size; done += (size_t)got) {
+			got = read(fd, checkpoint->buffer + done, checkpoint->size - done);
+			if(got <= 0) {
+				free(checkpoint->buffer);
+				checkpoint->buffer = NULL;
+			}
+		}
+		if(checkpoint->buffer == NULL) {
+			close(fd);
+			free(checkpoint);
+			return NULL;
+		}
+	}
+	close(fd);
+
+	memcpy(prefix, checkpoint->buffer + CHECKPOINT_HEADER_SIZE, sizeof(prefix));
+	if(memcmp(checkpoint->buffer, checkpoint_magic, sizeof(checkpoint_magic)) != 0
+		|| checkpoint->buffer[4] != CHECKPOINT_VERSION || prefix[0] != CHECKPOINT_ORDER) {
+		checkpointClose(checkpoint);
+		return NULL;
+	}
+	checkpoint->position = prefix[1];
+
+	return(checkpoint);
+}
+
+/* checkpointPosition
+ *
+ * Gives the trace position a checkpoint was taken at.
+ *
+ * @param	checkpoint		Target checkpoint
+ *
+ * @return	position		# of trace accesses to skip to resume
+ */
+
+unsigned long long checkpointPosition(Checkpoint checkpoint) {
+	return(checkpoint->position);
+}
+
+/* checkpointRestore
+ *
+ * Puts the saved state into a cache, as cacheRestore does.
+ *
+ * @param	checkpoint		Target checkpoint
+ * @param	cache			Cache of the same geometry, not yet used
+ *
+ * @return	success			1
+ * @return	mismatch		0
+ */
+
+int checkpointRestore(Checkpoint checkpoint, Cache cache) {
+	return(cacheRestore(cache, checkpoint->buffer + CHECKPOINT_PREFIX_SIZE,
+		(long)(checkpoint->size - CHECKPOINT_PREFIX_SIZE)));
+}
+
+/* checkpointClose
+ *
+ * Unmaps or frees a checkpoint. Passing NULL does nothing.
+ *
+ * @param	checkpoint		Target checkpoint
+ *
+ * @return	void
+ */
+
+void checkpointClose(Checkpoint checkpoint) {
+	if(checkpoint != NULL) {
+		if(checkpoint->mapped) {
+			munmap(checkpoint->buffer, checkpoint->size);
+		}
+		else {
+			free(checkpoint->buffer);
+		}
+		free(checkpoint);
+	}
+
+	return;
+}
+
+/* END OF FILE */
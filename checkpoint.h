@@ -0,0 +1,85 @@
+/* Description: Checkpoints of a cache, so that a long warm-up can be
+ *  run once and shared. A checkpoint holds the whole state of one
+ *  cache and the position in the trace it was taken at. The file
+ *  starts with the 8 bytes "CSCK", version 2, and three reserved
+ *  bytes, then a 64 bit byte order mark and the position, then the
+ *  cache as cacheSave writes it. Numbers are in the byte order of the
+ *  host that wrote the file, and another byte order is refused.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "cache_sim.h"
+
+/* Typedefs */
+typedef struct Checkpoint_* Checkpoint;
+
+/* checkpointWrite
+ *
+ * Writes a checkpoint of a cache.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	cache			Cache to save
+ * @param	position		# of trace accesses the cache has seen
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int checkpointWrite(const char *filename, Cache cache, unsigned long long position);
+
+/* checkpointOpen
+ *
+ * Opens a checkpoint for restoring, either mapped or read into memory.
+ * One open checkpoint can restore any number of caches, from any
+ * number of threads. Returns NULL if the file cannot be read or is not
+ * a checkpoint.
+ *
+ * @param	filename		Name of the checkpoint file
+ * @param	map				1 = Map the file, 0 = Read it into memory
+ *
+ * @return	success			checkpoint
+ * @return	failure			NULL
+ */
+
+Checkpoint checkpointOpen(const char *filename, int map);
+
+/* checkpointPosition
+ *
+ * Gives the trace position a checkpoint was taken at.
+ *
+ * @param	checkpoint		Target checkpoint
+ *
+ * @return	position		# of trace accesses to skip to resume
+ */
+
+unsigned long long checkpointPosition(Checkpoint checkpoint);
+
+/* checkpointRestore
+ *
+ * Puts the saved state into a cache, as cacheRestore does.
+ *
+ * @param	checkpoint		Target checkpoint
+ * @param	cache			Cache of the same geometry, not yet used
+ *
+ * @return	success			1
+ * @return	mismatch		0
+ */
+
+int checkpointRestore(Checkpoint checkpoint, Cache cache);
+
+/* checkpointClose
+ *
+ * Unmaps or frees a checkpoint. Passing NULL does nothing.
+ *
+ * @param	checkpoint		Target checkpoint
+ *
+ * @return	void
+ */
+
+void checkpointClose(Checkpoint checkpoint);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,241 @@
+/* Description: Open addressing hash map from 64 bit keys to 64 bit
+ *  values, using linear probing over a power of 2 table.
+ */
+
+/* Libraries */
+#include <assert.h>
+#include <stdlib.h>
+#include "hashmap.h"
+
+/* Structs */
+
+/* HashMap
+ *
+ * Keys and values are kept in two parallel arrays. A slot is empty
+ * when its bit in used is clear, so a key of 0 is allowed.
+ *
+ * @param	count			Number of keys held
+ * @param	mask			Table size - 1
+ * @param	keys			Key held by each slot
+ * @param	values			Value held by each slot
+ * @param	used			Bitmask, 1 = Slot holds a key
+ */
+
+struct HashMap_ {
+	long count;
+	unsigned long long mask;
+	unsigned long long *keys;
+	unsigned long long *values;
+	unsigned long long *used;
+};
+
+/* hashMix
+ *
+ * Scrambles the bits of a key so nearby block numbers land far apart.
+ *
+ * @param	key				Key to hash
+ *
+ * @return	hash			Hashed key
+ */
+
+static inline unsigned long long hashMix(unsigned long long key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ull;
+	key ^= key >> 33;
+	return(key);
+}
+
+/* hashMapAlloc
+ *
+ * Allocates empty slot arrays of the given size.
+ *
+ * @param	map				Target hash map
+ * @param	size			Number of slots, a power of 2
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int hashMapAlloc(HashMap map, unsigned long long size) {
+	map->keys = (unsigned long long *) malloc(sizeof(unsigned long long) * size);
+	map->values = (unsigned long long *) malloc(sizeof(unsigned long long) * size);
+	map->used = (unsigned long long *) calloc((size + 63) / 64, sizeof(unsigned long long));
+	if(map->keys == NULL || map->values == NULL || map->used == NULL) {
+		free(map->keys);
+		free(map->values);
+		free(map->used);
+		return(0);
+	}
+	map->mask = size - 1;
+
+	return(1);
+}
+
+/* hashMapGrow
+ *
+ * Doubles the table and re-inserts every key.
+ *
+ * @param	map				Target hash map
+ *
+ * @return	void
+ */
+
+static void hashMapGrow(HashMap map) {
+	unsigned long long *keys, *values, *used;
+	unsigned long long i, j, size;
+	int ok;
+
+	keys = map->keys;
+	values = map->values;
+	used = map->used;
+	size = map->mask + 1;
+
+	ok = hashMapAlloc(map, size * 2);
+	assert(ok);
+	(void)ok;
+	for(i = 0; i < size; i++) {
+		if((used[i >> 6] >> (i & 63)) & 1) {
+			j = hashMix(keys[i]) & map->mask;
+			while((map->used[j >> 6] >> (j & 63)) & 1) {
+				j = (j + 1) & map->mask;
+			}
+			map->keys[j] = keys[i];
+			map->values[j] = values[i];
+			map->used[j >> 6] |= 1ull << (j & 63);
+		}
+	}
+
+	free(keys);
+	free(values);
+	free(used);
+}
+
+/* hashMapCreate
+ *
+ * Creates an empty hash map. The table grows as needed, so capacity
+ * is only a starting size. Returns NULL on failure.
+ *
+ * @param	capacity		Expected number of keys
+ *
+ * @return	success			map
+ * @return	failure			NULL
+ */
+
+HashMap hashMapCreate(long capacity) {
+	HashMap map;
+	unsigned long long size = 64;
+
+	map = (HashMap) malloc(sizeof(struct HashMap_));
+	if(map == NULL) {
+		return NULL;
+	}
+
+	/* Keep the load factor under one half */
+	while(size < (unsigned long long)capacity * 2) {
+		size <<= 1;
+	}
+	if(!hashMapAlloc(map, size)) {
+		free(map);
+		return NULL;
+	}
+	map->count = 0;
+
+	return(map);
+}
+
+/* hashMapDestroy
+ *
+ * Frees a hash map. Passing NULL does nothing.
+ *
+ * @param	map				Target hash map
+ *
+ * @return	void
+ */
+
+void hashMapDestroy(HashMap map) {
+	if(map != NULL) {
+		free(map->keys);
+		free(map->values);
+		free(map->used);
+		free(map);
+	}
+}
+
+/* hashMapFind
+ *
+ * Looks up a key.
+ *
+ * @param	map				Target hash map
+ * @param	key				Key to look up
+ *
+ * @return	found			Pointer to the value of the key
+ * @return	not found		NULL
+ */
+
+unsigned long long *hashMapFind(HashMap map, unsigned long long key) {
+	unsigned long long i;
+
+	i = hashMix(key) & map->mask;
+	while((map->used[i >> 6] >> (i & 63)) & 1) {
+		if(map->keys[i] == key) {
+			return(&map->values[i]);
+		}
+		i = (i + 1) & map->mask;
+	}
+
+	return(NULL);
+}
+
+/* hashMapInsert
+ *
+ * Looks up a key and adds it with a value of 0 if it is not there.
+ * The returned pointer stays valid until the next insert.
+ *
+ * @param	map				Target hash map
+ * @param	key				Key to look up or add
+ * @param	added			Set to 1 if the key was added, else 0
+ *
+ * @return	value			Pointer to the value of the key
+ */
+
+unsigned long long *hashMapInsert(HashMap map, unsigned long long key, int *added) {
+	unsigned long long i;
+
+	if((unsigned long long)(map->count + 1) * 2 > map->mask + 1) {
+		hashMapGrow(map);
+	}
+
+	i = hashMix(key) & map->mask;
+	while((map->used[i >> 6] >> (i & 63)) & 1) {
+		if(map->keys[i] == key) {
+			*added = 0;
+			return(&map->values[i]);
+		}
+		i = (i + 1) & map->mask;
+	}
+
+	map->keys[i] = key;
+	map->values[i] = 0;
+	map->used[i >> 6] |= 1ull << (i & 63);
+	map->count++;
+	*added = 1;
+
+	return(&map->values[i]);
+}
+
+/* hashMapCount
+ *
+ * Returns the number of keys held by a hash map.
+ *
+ * @param	map				Target hash map
+ *
+ * @return	count			Number of keys
+ */
+
+long hashMapCount(HashMap map) {
+	return(map->count);
+}
+
+/* END OF FILE */
@@ -0,0 +1,76 @@
+/* Description: Open addressing hash map from 64 bit keys to 64 bit
+ *  values. Used to track per-block state, such as which main memory
+ *  blocks have been seen, without keeping the whole trace around.
+ */
+
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+/* Typedefs */
+typedef struct HashMap_* HashMap;
+
+/* hashMapCreate
+ *
+ * Creates an empty hash map. The table grows as needed, so capacity
+ * is only a starting size. Returns NULL on failure.
+ *
+ * @param	capacity		Expected number of keys
+ *
+ * @return	success			map
+ * @return	failure			NULL
+ */
+
+HashMap hashMapCreate(long capacity);
+
+/* hashMapDestroy
+ *
+ * Frees a hash map. Passing NULL does nothing.
+ *
+ * @param	map				Target hash map
+ *
+ * @return	void
+ */
+
+void hashMapDestroy(HashMap map);
+
+/* hashMapFind
+ *
+ * Looks up a key.
+ *
+ * @param	map				Target hash map
+ * @param	key				Key to look up
+ *
+ * @return	found			Pointer to the value of the key
+ * @return	not found		NULL
+ */
+
+unsigned long long *hashMapFind(HashMap map, unsigned long long key);
+
+/* hashMapInsert
+ *
+ * Looks up a key and adds it with a value of 0 if it is not there.
+ * The returned pointer stays valid until the next insert.
+ *
+ * @param	map				Target hash map
+ * @param	key				Key to look up or add
+ * @param	added			Set to 1 if the key was added, else 0
+ *
+ * @return	value			Pointer to the value of the key
+ */
+
+unsigned long long *hashMapInsert(HashMap map, unsigned long long key, int *added);
+
+/* hashMapCount
+ *
+ * Returns the number of keys held by a hash map.
+ *
+ * @param	map				Target hash map
+ *
+ * @return	count			Number of keys
+ */
+
+long hashMapCount(HashMap map);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,364 @@
+/* Description: Chain of cache levels in front of main memory. Each
+ *  level is an ordinary Cache. The hierarchy moves blocks between them
+ *  and keeps its own counters for every level.
+ */
+
+/* Libraries */
+#include <stdlib.h>
+#include <string.h>
+#include "hierarchy.h"
+
+/* Structs */
+
+/* Hierarchy
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	inclusion		HIER_NINE, HIER_INCLUSIVE, or HIER_EXCLUSIVE
+ * @param	count			Number of levels
+ * @param	levels			Cache of each level, first level first
+ * @param	block_sizes		Block size of each level
+ * @param	stats			Counters of each level, then of main memory
+ */
+
+struct Hierarchy_ {
+	long long mm_size;
+	int inclusion;
+	int count;
+	Cache levels[HIER_LEVELS_MAX];
+	unsigned int block_sizes[HIER_LEVELS_MAX];
+	CacheStats stats[HIER_LEVELS_MAX + 1];
+};
+
+/* hierarchyStep
+ *
+ * Gives how far apart the accesses to the next level are when a whole
+ * block of one level is fetched or written back. A smaller block below
+ * takes several accesses, and a bigger one takes just one.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level # whose block is moving
+ *
+ * @return	step			Bytes between accesses to the next level
+ */
+
+static unsigned int hierarchyStep(Hierarchy hierarchy, int level) {
+	if(level + 1 < hierarchy->count
+		&& hierarchy->block_sizes[level + 1] < hierarchy->block_sizes[level]) {
+		return(hierarchy->block_sizes[level + 1]);
+	}
+
+	return(hierarchy->block_sizes[level]);
+}
+
+/* hierarchyDown
+ *
+ * Accesses one level of a non-inclusive or inclusive hierarchy. A miss
+ * fetches the block from the next level, and a dirty victim is written
+ * to it. In an inclusive hierarchy a victim is also dropped from every
+ * level above, and any dirty copy there is written back with it.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level # to access, count for main memory
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	hit				1
+ * @return	miss			0
+ */
+
+static int hierarchyDown(Hierarchy hierarchy, int level, unsigned long long address, int write) {
+	CacheStats *stats = &hierarchy->stats[level];
+	unsigned long long base, victim, a;
+	unsigned int block_size, step;
+	int evicted, dirty, j;
+
+	if(level == hierarchy->count) {
+		if(write) {
+			stats->writes++;
+		}
+		else {
+			stats->reads++;
+		}
+		return(1);
+	}
+
+	if(cacheAccessNext(hierarchy->levels[level], address, write, CACHE_NEVER)) {
+		stats->hits++;
+		return(1);
+	}
+	stats->misses++;
+	evicted = cacheEvicted(hierarchy->levels[level], &victim, &dirty);
+
+	/* Fetch the whole block from the level below */
+	block_size = hierarchy->block_sizes[level];
+	step = hierarchyStep(hierarchy, level);
+	base = address - address % block_size;
+	stats->reads++;
+	for(a = base; a - base < block_size; a += step) {
+		hierarchyDown(hierarchy, level + 1, a, 0);
+	}
+
+	if(evicted) {
+		if(hierarchy->inclusion == HIER_INCLUSIVE) {
+			for(j = 0; j < level; j++) {
+				for(a = victim; a - victim < block_size; a += hierarchy->block_sizes[j]) {
+					if(cacheInvalidate(hierarchy->levels[j], a) == 2) {
+						dirty = 1;
+					}
+				}
+			}
+		}
+		if(dirty) {
+			stats->writes++;
+			for(a = victim; a - victim < block_size; a += step) {
+				hierarchyDown(hierarchy, level + 1, a, 1);
+			}
+		}
+	}
+
+	return(0);
+}
+
+/* hierarchyTake
+ *
+ * Looks for a block below the first level of an exclusive hierarchy.
+ * The level that holds it gives it up, since it is moving to the first
+ * level. Levels that miss are skipped over and not filled.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level # to look in, count for main memory
+ * @param	address			Integer address
+ *
+ * @return	dirty			1
+ * @return	clean			0
+ */
+
+static int hierarchyTake(Hierarchy hierarchy, int level, unsigned long long address) {
+	CacheStats *stats = &hierarchy->stats[level];
+	int held;
+
+	if(level == hierarchy->count) {
+		stats->reads++;
+		return(0);
+	}
+
+	held = cacheInvalidate(hierarchy->levels[level], address);
+	if(held) {
+		stats->hits++;
+		return(held == 2);
+	}
+	stats->misses++;
+	stats->reads++;
+
+	return(hierarchyTake(hierarchy, level + 1, address));
+}
+
+/* hierarchyVictim
+ *
+ * Moves a block evicted from the level above into a level of an
+ * exclusive hierarchy. Whatever that pushes out moves further down,
+ * and dirty blocks that fall out of the last level go to memory.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level # to fill, count for main memory
+ * @param	address			First address of the block
+ * @param	dirty			1 = The block is dirty
+ *
+ * @return	void
+ */
+
+static void hierarchyVictim(Hierarchy hierarchy, int level, unsigned long long address,
+	int dirty) {
+	unsigned long long victim;
+	int victim_dirty;
+
+	while(level < hierarchy->count) {
+		cacheFill(hierarchy->levels[level], address, dirty);
+		if(!cacheEvicted(hierarchy->levels[level], &victim, &victim_dirty)) {
+			return;
+		}
+		if(victim_dirty) {
+			hierarchy->stats[level].writes++;
+		}
+		address = victim;
+		dirty = victim_dirty;
+		level++;
+	}
+	if(dirty) {
+		hierarchy->stats[level].writes++;
+	}
+}
+
+/* hierarchyCreate
+ *
+ * Creates a hierarchy with no levels, so every access goes to main
+ * memory until levels are added. Returns NULL on failure.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	inclusion		HIER_NINE, HIER_INCLUSIVE, or HIER_EXCLUSIVE
+ *
+ * @return	success			hierarchy
+ * @return	failure			NULL
+ */
+
+Hierarchy hierarchyCreate(long long mm_size, int inclusion) {
+	Hierarchy hierarchy;
+
+	hierarchy = (Hierarchy) malloc(sizeof(struct Hierarchy_));
+	if(hierarchy == NULL) {
+		return NULL;
+	}
+	memset(hierarchy, 0, sizeof(struct Hierarchy_));
+	hierarchy->mm_size = mm_size;
+	hierarchy->inclusion = inclusion;
+
+	return(hierarchy);
+}
+
+/* hierarchyDestroy
+ *
+ * Frees a hierarchy and all of its caches. Passing NULL does nothing.
+ *
+ * @param	hierarchy		Target hierarchy
+ *
+ * @return	void
+ */
+
+void hierarchyDestroy(Hierarchy hierarchy) {
+	int i;
+
+	if(hierarchy != NULL) {
+		for(i = 0; i < hierarchy->count; i++) {
+			cacheDestroy(hierarchy->levels[i]);
+		}
+		free(hierarchy);
+	}
+}
+
+/* hierarchyAddLevel
+ *
+ * Adds a cache below the last level. Inclusive hierarchies need each
+ * block to be at least as big as the block of the level above, and
+ * exclusive ones need every level to use the same block size.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		Any CACHE_ policy number but OPT
+ *
+ * @return	success			NULL
+ * @return	failure			Reason the level cannot be added
+ */
+
+const char *hierarchyAddLevel(Hierarchy hierarchy, long long cache_size, int block_size, int nSA,
+	int rep_policy) {
+	Cache cache;
+	unsigned int above;
+
+	if(hierarchy->count == HIER_LEVELS_MAX) {
+		return("too many levels");
+	}
+	if(rep_policy == CACHE_OPT) {
+		return("levels cannot use OPT");
+	}
+	if(hierarchy->count > 0) {
+		above = hierarchy->block_sizes[hierarchy->count - 1];
+		if(hierarchy->inclusion == HIER_INCLUSIVE && (unsigned int)block_size < above) {
+			return("inclusive levels need blocks at least as big as the level above");
+		}
+		if(hierarchy->inclusion == HIER_EXCLUSIVE && (unsigned int)block_size != above) {
+			return("exclusive levels need the same block size");
+		}
+	}
+
+	cache = cacheCreate(cache_size, block_size, rep_policy);
+	if(cache == NULL) {
+		return("not enough memory");
+	}
+	cacheSetGeometry(cache, hierarchy->mm_size, nSA);
+
+	hierarchy->levels[hierarchy->count] = cache;
+	hierarchy->block_sizes[hierarchy->count] = (unsigned int)block_size;
+	hierarchy->count++;
+
+	return(NULL);
+}
+
+/* hierarchyLevels
+ *
+ * Gives the number of cache levels of a hierarchy.
+ *
+ * @param	hierarchy		Target hierarchy
+ *
+ * @return	count			Number of levels
+ */
+
+int hierarchyLevels(Hierarchy hierarchy) {
+	return(hierarchy->count);
+}
+
+/* hierarchyAccess
+ *
+ * Reads or writes one address through every level that is needed.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	hit				1, the first level held the block
+ * @return	miss			0
+ */
+
+int hierarchyAccess(Hierarchy hierarchy, unsigned long long address, int write) {
+	Cache first;
+	unsigned long long victim;
+	int evicted, dirty;
+
+	if(hierarchy->inclusion != HIER_EXCLUSIVE || hierarchy->count == 0) {
+		return(hierarchyDown(hierarchy, 0, address, write) && hierarchy->count > 0);
+	}
+
+	/* Exclusive: the first level takes the block from whichever level
+	 * holds it and hands its victim to the level below */
+	first = hierarchy->levels[0];
+	if(cacheAccessNext(first, address, write, CACHE_NEVER)) {
+		hierarchy->stats[0].hits++;
+		return(1);
+	}
+	hierarchy->stats[0].misses++;
+	hierarchy->stats[0].reads++;
+	evicted = cacheEvicted(first, &victim, &dirty);
+
+	if(hierarchyTake(hierarchy, 1, address)) {
+		cacheFill(first, address, 1);
+	}
+	if(evicted) {
+		if(dirty) {
+			hierarchy->stats[0].writes++;
+		}
+		hierarchyVictim(hierarchy, 1, victim, dirty);
+	}
+
+	return(0);
+}
+
+/* hierarchyGetStats
+ *
+ * Copies the counters of one level. Reads are blocks fetched from the
+ * level below and writes are dirty blocks written to it. Passing the
+ * number of levels gives main memory, which only counts reads and
+ * writes.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level #, 0 is the first level
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void hierarchyGetStats(Hierarchy hierarchy, int level, CacheStats *stats) {
+	*stats = hierarchy->stats[level];
+}
+
+/* END OF FILE */
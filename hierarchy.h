@@ -0,0 +1,109 @@
+/* Description: Chain of cache levels, such as L1, L2, and L3, in front
+ *  of main memory. Misses and dirty evictions of one level become
+ *  accesses to the next, so a whole hierarchy is simulated in one pass
+ *  over the trace.
+ */
+
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "cache_sim.h"
+
+#define HIER_LEVELS_MAX		8
+
+/* Inclusion policies */
+#define HIER_NINE			0
+#define HIER_INCLUSIVE		1
+#define HIER_EXCLUSIVE		2
+
+/* Typedefs */
+typedef struct Hierarchy_* Hierarchy;
+
+/* hierarchyCreate
+ *
+ * Creates a hierarchy with no levels, so every access goes to main
+ * memory until levels are added. Returns NULL on failure.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	inclusion		HIER_NINE, HIER_INCLUSIVE, or HIER_EXCLUSIVE
+ *
+ * @return	success			hierarchy
+ * @return	failure			NULL
+ */
+
+Hierarchy hierarchyCreate(long long mm_size, int inclusion);
+
+/* hierarchyDestroy
+ *
+ * Frees a hierarchy and all of its caches. Passing NULL does nothing.
+ *
+ * @param	hierarchy		Target hierarchy
+ *
+ * @return	void
+ */
+
+void hierarchyDestroy(Hierarchy hierarchy);
+
+/* hierarchyAddLevel
+ *
+ * Adds a cache below the last level. Inclusive hierarchies need each
+ * block to be at least as big as the block of the level above, and
+ * exclusive ones need every level to use the same block size.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		Any CACHE_ policy number but OPT
+ *
+ * @return	success			NULL
+ * @return	failure			Reason the level cannot be added
+ */
+
+const char *hierarchyAddLevel(Hierarchy hierarchy, long long cache_size, int block_size, int nSA,
+	int rep_policy);
+
+/* hierarchyLevels
+ *
+ * Gives the number of cache levels of a hierarchy.
+ *
+ * @param	hierarchy		Target hierarchy
+ *
+ * @return	count			Number of levels
+ */
+
+int hierarchyLevels(Hierarchy hierarchy);
+
+/* hierarchyAccess
+ *
+ * Reads or writes one address through every level that is needed.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	hit				1, the first level held the block
+ * @return	miss			0
+ */
+
+int hierarchyAccess(Hierarchy hierarchy, unsigned long long address, int write);
+
+/* hierarchyGetStats
+ *
+ * Copies the counters of one level. Reads are blocks fetched from the
+ * level below and writes are dirty blocks written to it. Passing the
+ * number of levels gives main memory, which only counts reads and
+ * writes.
+ *
+ * @param	hierarchy		Target hierarchy
+ * @param	level			Level #, 0 is the first level
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void hierarchyGetStats(Hierarchy hierarchy, int level, CacheStats *stats);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,733 @@
+/* Description: Multicore trace replay with MESI coherence. Every core
+ *  has a private cache, and a directory keeps the set of cores holding
+ *  each block. A private hit on a block no other core has touched
+ *  since this core last did cannot be changed by other cores, so it is
+ *  served on the core's own thread without any locking. Everything
+ *  else is a coherence event. Events run one at a time under a global
+ *  lock, and each waits until every other core has got past it in the
+ *  trace, so events happen in trace order.
+ */
+
+/* Libraries */
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hashmap.h"
+#include "multicore.h"
+#include "policy.h"
+
+/* MESI states of a private block */
+#define MC_INVALID		0
+#define MC_SHARED		1
+#define MC_EXCLUSIVE	2
+#define MC_MODIFIED		3
+
+#define MC_RING_SIZE	4096
+#define MC_NONE			(~0ull)
+
+/* Structs */
+
+/* CoreAccess
+ *
+ * One access handed from the parser to a core.
+ *
+ * @param	seq				Position of the access in the trace
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ * @param	shared			1 if another core used the block since this
+ *							core last did
+ */
+
+struct CoreAccess_ {
+	unsigned long long seq;
+	unsigned long long address;
+	char write;
+	char shared;
+};
+
+/* Core
+ *
+ * Private cache and thread state of one core. Block states are only
+ * read and written with atomics, because coherence events of other
+ * cores may invalidate blocks while the core serves its own hits.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	id				Core #
+ * @param	tags			Tag held by each block
+ * @param	states			MESI state of each block
+ * @param	policy			Replacement metadata of every set
+ * @param	stats			Counters of the core
+ * @param	ring			Accesses waiting for the core's thread
+ * @param	head			Number of accesses the core has finished
+ * @param	tail			Number of accesses handed to the core
+ * @param	next_seq		Trace position after the last finished access
+ * @param	pending			Trace position of the event the core waits
+ *							to run, or MC_NONE
+ * @param	finished		1 once the core's thread is done
+ * @param	thread			The core's thread
+ */
+
+struct Core_ {
+	Multicore mc;
+	int id;
+	unsigned long long *tags;
+	unsigned char *states;
+	Policy policy;
+	CoreStats stats;
+	struct CoreAccess_ *ring;
+	unsigned long long head __attribute__((aligned(64)));
+	unsigned long long next_seq;
+	unsigned long long pending;
+	int finished;
+	unsigned long long tail __attribute__((aligned(64)));
+	pthread_t thread;
+} __attribute__((aligned(64)));
+
+/* Multicore
+ *
+ * @param	core_count		Number of cores
+ * @param	mm_size			Size of main memory in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	block_count		Number of blocks of each private cache
+ * @param	set_count		Number of sets of each private cache
+ * @param	nSA				Set-Associativity of the private caches
+ * @param	rep_policy		One of the CACHE_ policy numbers, except OPT
+ * @param	shared			Shared cache level, or NULL
+ * @param	memory			Reads and writes of main memory
+ * @param	directory		Block # to bitmask of the cores holding it
+ * @param	lock			Taken by every coherence event
+ * @param	parser_next		Trace position of the next access to parse
+ * @param	parser_done		1 once the whole trace has been handed out
+ * @param	cores			The cores
+ */
+
+struct Multicore_ {
+	int core_count;
+	long long mm_size;
+	int block_size;
+	int block_count;
+	int set_count;
+	int nSA;
+	int rep_policy;
+	Cache shared;
+	CacheStats memory;
+	HashMap directory;
+	pthread_mutex_t lock;
+	unsigned long long parser_next __attribute__((aligned(64)));
+	int parser_done;
+	struct Core_ *cores;
+};
+
+/* coreState, coreSetState
+ *
+ * Read and update the MESI state of one private block.
+ *
+ * @param	core			Target core
+ * @param	way				Block #
+ * @param	state			New state
+ *
+ * @return	state			Current state, for coreState
+ */
+
+static inline int coreState(struct Core_ *core, int way) {
+	return(__atomic_load_n(&core->states[way], __ATOMIC_RELAXED));
+}
+
+static inline void coreSetState(struct Core_ *core, int way, int state) {
+	__atomic_store_n(&core->states[way], (unsigned char)state, __ATOMIC_RELAXED);
+}
+
+/* coreFind
+ *
+ * Looks for a valid block among the ways of a set of a private cache.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Target core
+ * @param	set				Cache set #
+ * @param	tag				Tag to look for
+ *
+ * @return	found			Block # holding the tag
+ * @return	not found		-1
+ */
+
+static inline int coreFind(Multicore mc, struct Core_ *core, int set, unsigned long long tag) {
+	int i, first, last;
+
+	first = set * mc->nSA;
+	last = first + mc->nSA;
+	for(i = first; i < last; i++) {
+		if(core->tags[i] == tag && coreState(core, i) != MC_INVALID) {
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/* coreTouch
+ *
+ * Tells the replacement policy of a private cache that a block was
+ * used again. Only the core's own thread drives its policy.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Target core
+ * @param	way				Block #
+ *
+ * @return	void
+ */
+
+static inline void coreTouch(Multicore mc, struct Core_ *core, int way) {
+	policyHit(core->policy, way / mc->nSA, way % mc->nSA, CACHE_NEVER);
+}
+
+/* coreFast
+ *
+ * Serves an access from the private cache alone, if it can be. That
+ * is the case for a block no other core has used since this core last
+ * did, which is held with enough rights: any valid state for a read,
+ * E or M for a write. Takes no locks.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Target core
+ * @param	access			Access to serve
+ *
+ * @return	served			1
+ * @return	coherence event	0
+ */
+
+static int coreFast(Multicore mc, struct Core_ *core, const struct CoreAccess_ *access) {
+	unsigned long long mm_block;
+	int way, state;
+
+	if(access->shared) {
+		return(0);
+	}
+
+	mm_block = access->address / (unsigned int)mc->block_size;
+	way = coreFind(mc, core, (int)(mm_block % (unsigned int)mc->set_count),
+		mm_block / (unsigned int)mc->set_count);
+	if(way < 0) {
+		return(0);
+	}
+	state = coreState(core, way);
+	if(access->write) {
+		if(state == MC_SHARED) {
+			return(0);
+		}
+		coreSetState(core, way, MC_MODIFIED);
+	}
+
+	coreTouch(mc, core, way);
+	core->stats.accesses++;
+	core->stats.hits++;
+
+	return(1);
+}
+
+/* multicoreBelow
+ *
+ * Reads or writes a block in the level below the private caches.
+ *
+ * @param	mc				Target multicore
+ * @param	address			Any address inside the block
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	void
+ */
+
+static void multicoreBelow(Multicore mc, unsigned long long address, int write) {
+	if(mc->shared != NULL) {
+		cacheAccessNext(mc->shared, address, write, CACHE_NEVER);
+	}
+	else if(write) {
+		mc->memory.writes++;
+	}
+	else {
+		mc->memory.reads++;
+	}
+}
+
+/* coreEvent
+ *
+ * Runs an access that needs the rest of the system. A miss snoops the
+ * other copies through the directory: a write invalidates them, a read
+ * turns them into S, and an M copy supplies the data. A write to an S
+ * block upgrades it by invalidating the other copies. Must only be
+ * called by one core at a time, in trace order.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Core making the access
+ * @param	access			Access to run
+ *
+ * @return	void
+ */
+
+static void coreEvent(Multicore mc, struct Core_ *core, const struct CoreAccess_ *access) {
+	struct Core_ *other;
+	unsigned long long *sharers, *victim_sharers, bit, others;
+	unsigned long long mm_block, tag, victim;
+	int set, way, state, new_state, added, d, w, i, first, last;
+	int supplied = 0;
+
+	mm_block = access->address / (unsigned int)mc->block_size;
+	set = (int)(mm_block % (unsigned int)mc->set_count);
+	tag = mm_block / (unsigned int)mc->set_count;
+	bit = 1ull << core->id;
+	sharers = hashMapInsert(mc->directory, mm_block, &added);
+	others = *sharers & ~bit;
+	core->stats.accesses++;
+
+	way = coreFind(mc, core, set, tag);
+	if(way >= 0) {
+		core->stats.hits++;
+		state = coreState(core, way);
+		if(access->write && state == MC_SHARED) {
+			core->stats.upgrades++;
+			for(d = 0; others != 0; d++, others >>= 1) {
+				if(others & 1) {
+					other = &mc->cores[d];
+					coreSetState(other, coreFind(mc, other, set, tag), MC_INVALID);
+					other->stats.invalidations++;
+				}
+			}
+			*sharers = bit;
+		}
+		if(access->write) {
+			coreSetState(core, way, MC_MODIFIED);
+		}
+		coreTouch(mc, core, way);
+		return;
+	}
+	core->stats.misses++;
+
+	/* Snoop every other copy of the block */
+	for(d = 0; others != 0; d++, others >>= 1) {
+		if(!(others & 1)) {
+			continue;
+		}
+		other = &mc->cores[d];
+		w = coreFind(mc, other, set, tag);
+		state = coreState(other, w);
+		if(state == MC_MODIFIED) {
+			supplied = 1;
+			if(!access->write) {
+				other->stats.writebacks++;
+				multicoreBelow(mc, access->address, 1);
+			}
+		}
+		if(access->write) {
+			coreSetState(other, w, MC_INVALID);
+			other->stats.invalidations++;
+		}
+		else if(state != MC_SHARED) {
+			coreSetState(other, w, MC_SHARED);
+		}
+	}
+	if(access->write) {
+		new_state = MC_MODIFIED;
+		others = *sharers & ~bit;
+		*sharers = bit;
+	}
+	else {
+		others = *sharers & ~bit;
+		new_state = (others != 0) ? MC_SHARED : MC_EXCLUSIVE;
+		*sharers |= bit;
+	}
+	if(supplied) {
+		core->stats.transfers++;
+	}
+	else {
+		multicoreBelow(mc, access->address, 0);
+	}
+
+	/* Fill the first invalid way, else the policy's victim */
+	first = set * mc->nSA;
+	last = first + mc->nSA;
+	for(i = first; i < last; i++) {
+		if(coreState(core, i) == MC_INVALID) {
+			break;
+		}
+	}
+	way = (i < last) ? i : first + policyVictim(core->policy, set);
+	state = coreState(core, way);
+	if(state != MC_INVALID) {
+		victim = core->tags[way] * (unsigned int)mc->set_count + (unsigned int)set;
+		victim_sharers = hashMapFind(mc->directory, victim);
+		*victim_sharers &= ~bit;
+		if(state == MC_MODIFIED) {
+			core->stats.writebacks++;
+			multicoreBelow(mc, victim * (unsigned int)mc->block_size, 1);
+		}
+	}
+	core->tags[way] = tag;
+	coreSetState(core, way, new_state);
+	policyInsert(core->policy, set, way - first, CACHE_NEVER);
+}
+
+/* coreBound
+ *
+ * Gives a trace position that a core has not yet reached. Every access
+ * of the core before it is finished.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Core to look at
+ *
+ * @return	position		Lowest position the core may still run
+ */
+
+static unsigned long long coreBound(Multicore mc, struct Core_ *core) {
+	unsigned long long pending, parsed;
+
+	if(__atomic_load_n(&core->finished, __ATOMIC_ACQUIRE)) {
+		return(MC_NONE);
+	}
+	pending = __atomic_load_n(&core->pending, __ATOMIC_ACQUIRE);
+	if(pending != MC_NONE) {
+		return(pending);
+	}
+
+	/* A core that finished all it was given waits for the parser */
+	parsed = __atomic_load_n(&mc->parser_next, __ATOMIC_ACQUIRE);
+	if(__atomic_load_n(&core->head, __ATOMIC_ACQUIRE)
+		== __atomic_load_n(&core->tail, __ATOMIC_ACQUIRE)) {
+		return(parsed);
+	}
+
+	return(__atomic_load_n(&core->next_seq, __ATOMIC_ACQUIRE));
+}
+
+/* coreWait
+ *
+ * Waits until every other core is past a trace position, so that the
+ * event there is the next one in trace order.
+ *
+ * @param	mc				Multicore the core belongs to
+ * @param	core			Core waiting
+ * @param	seq				Trace position of its event
+ *
+ * @return	void
+ */
+
+static void coreWait(Multicore mc, struct Core_ *core, unsigned long long seq) {
+	int d;
+
+	for(;;) {
+		for(d = 0; d < mc->core_count; d++) {
+			if(d != core->id && coreBound(mc, &mc->cores[d]) <= seq) {
+				break;
+			}
+		}
+		if(d == mc->core_count) {
+			return;
+		}
+		sched_yield();
+	}
+}
+
+/* coreWorker
+ *
+ * Thread body of one core. Serves accesses from its ring until the
+ * parser is done and the ring is empty.
+ *
+ * @param	arg				The Core
+ *
+ * @return	NULL
+ */
+
+static void *coreWorker(void *arg) {
+	struct Core_ *core = (struct Core_ *)arg;
+	Multicore mc = core->mc;
+	struct CoreAccess_ access;
+	unsigned long long head;
+
+	head = core->head;
+	for(;;) {
+		if(head == __atomic_load_n(&core->tail, __ATOMIC_ACQUIRE)) {
+			if(__atomic_load_n(&mc->parser_done, __ATOMIC_ACQUIRE)
+				&& head == __atomic_load_n(&core->tail, __ATOMIC_ACQUIRE)) {
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+
+		access = core->ring[head & (MC_RING_SIZE - 1)];
+		if(!coreFast(mc, core, &access)) {
+			__atomic_store_n(&core->pending, access.seq, __ATOMIC_RELEASE);
+			coreWait(mc, core, access.seq);
+			pthread_mutex_lock(&mc->lock);
+			coreEvent(mc, core, &access);
+			pthread_mutex_unlock(&mc->lock);
+			__atomic_store_n(&core->pending, MC_NONE, __ATOMIC_RELEASE);
+		}
+		__atomic_store_n(&core->next_seq, access.seq + 1, __ATOMIC_RELEASE);
+		head++;
+		__atomic_store_n(&core->head, head, __ATOMIC_RELEASE);
+	}
+	__atomic_store_n(&core->finished, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/* multicoreCreate
+ *
+ * Creates the private caches of every core. Returns NULL on failure.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cores			Number of cores, at most MULTICORE_MAX
+ * @param	cache_size		Size of each private cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity of the private caches
+ * @param	rep_policy		One of the CACHE_ policy numbers, except OPT
+ *
+ * @return	success			multicore
+ * @return	failure			NULL
+ */
+
+Multicore multicoreCreate(long long mm_size, int cores, long long cache_size, int block_size, int nSA,
+	int rep_policy) {
+	Multicore mc;
+	struct Core_ *core;
+	int i;
+
+	if(cores < 1 || cores > MULTICORE_MAX
+		|| rep_policy == CACHE_OPT || policyName(rep_policy) == NULL) {
+		return NULL;
+	}
+
+	mc = (Multicore) calloc(1, sizeof(struct Multicore_));
+	if(mc == NULL) {
+		return NULL;
+	}
+	mc->core_count = cores;
+	mc->mm_size = mm_size;
+	mc->block_size = block_size;
+	mc->block_count = (int)(cache_size / block_size);
+	mc->nSA = nSA;
+	mc->set_count = mc->block_count / nSA;
+	mc->rep_policy = rep_policy;
+	pthread_mutex_init(&mc->lock, NULL);
+
+	mc->directory = hashMapCreate(1024);
+	if(posix_memalign((void **)&mc->cores, 64, sizeof(struct Core_) * cores) != 0) {
+		mc->cores = NULL;
+	}
+	if(mc->directory == NULL || mc->cores == NULL) {
+		hashMapDestroy(mc->directory);
+		free(mc->cores);
+		free(mc);
+		return NULL;
+	}
+	memset(mc->cores, 0, sizeof(struct Core_) * cores);
+
+	for(i = 0; i < cores; i++) {
+		core = &mc->cores[i];
+		core->mc = mc;
+		core->id = i;
+		core->pending = MC_NONE;
+		core->tags = (unsigned long long *) calloc(mc->block_count, sizeof(unsigned long long));
+		core->states = (unsigned char *) calloc(mc->block_count, sizeof(unsigned char));
+		core->policy = policyCreate(rep_policy, mc->set_count, nSA);
+		if(core->tags == NULL || core->states == NULL || core->policy == NULL) {
+			mc->core_count = i + 1;
+			multicoreDestroy(mc);
+			return NULL;
+		}
+	}
+
+	return(mc);
+}
+
+/* multicoreDestroy
+ *
+ * Frees a multicore and all of its caches. Passing NULL does nothing.
+ *
+ * @param	mc				Target multicore
+ *
+ * @return	void
+ */
+
+void multicoreDestroy(Multicore mc) {
+	int i;
+
+	if(mc != NULL) {
+		for(i = 0; i < mc->core_count; i++) {
+			free(mc->cores[i].tags);
+			free(mc->cores[i].states);
+			policyDestroy(mc->cores[i].policy);
+			free(mc->cores[i].ring);
+		}
+		free(mc->cores);
+		cacheDestroy(mc->shared);
+		hashMapDestroy(mc->directory);
+		pthread_mutex_destroy(&mc->lock);
+		free(mc);
+	}
+}
+
+/* multicoreSetShared
+ *
+ * Adds a cache level shared by every core, below the private caches.
+ * Without one, private misses and writebacks go to main memory.
+ *
+ * @param	mc				Target multicore
+ * @param	cache_size		Size of the shared cache in bytes
+ * @param	block_size		Size of each block, same as the private caches
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers, except OPT
+ *
+ * @return	success			NULL
+ * @return	failure			Reason the level cannot be added
+ */
+
+const char *multicoreSetShared(Multicore mc, long long cache_size, int block_size, int nSA,
+	int rep_policy) {
+	if(block_size != mc->block_size) {
+		return("the shared level needs the same block size as the private caches");
+	}
+	if(rep_policy == CACHE_OPT) {
+		return("the shared level cannot use OPT");
+	}
+
+	cacheDestroy(mc->shared);
+	mc->shared = cacheCreate(cache_size, block_size, rep_policy);
+	if(mc->shared == NULL) {
+		return("not enough memory");
+	}
+	cacheSetGeometry(mc->shared, mc->mm_size, nSA);
+
+	return(NULL);
+}
+
+/* multicoreRun
+ *
+ * Replays a whole trace. With more than one thread, every core gets
+ * its own thread and the calling thread parses the trace. Accesses
+ * from cores the multicore does not have are skipped.
+ *
+ * @param	mc				Target multicore
+ * @param	trace			Opened trace to replay
+ * @param	threads			1 = Run everything on the calling thread
+ *
+ * @return	success			# of accesses skipped
+ * @return	failure			-1
+ */
+
+long long multicoreRun(Multicore mc, Trace trace, int threads) {
+	HashMap last_core;
+	struct Core_ *core;
+	struct CoreAccess_ access;
+	unsigned long long *last, seq = 0, address;
+	long long skipped = 0;
+	char mode;
+	int c, added, started = 0;
+
+	/* Remembers which core used each block last */
+	last_core = hashMapCreate(1024);
+	if(last_core == NULL) {
+		return(-1);
+	}
+
+	if(threads > 1) {
+		for(c = 0; c < mc->core_count; c++) {
+			core = &mc->cores[c];
+			core->ring = (struct CoreAccess_ *) malloc(sizeof(struct CoreAccess_) * MC_RING_SIZE);
+			if(core->ring == NULL
+				|| pthread_create(&core->thread, NULL, coreWorker, core) != 0) {
+				break;
+			}
+			started++;
+		}
+		if(started < mc->core_count) {
+			__atomic_store_n(&mc->parser_done, 1, __ATOMIC_RELEASE);
+			for(c = 0; c < started; c++) {
+				pthread_join(mc->cores[c].thread, NULL);
+			}
+			hashMapDestroy(last_core);
+			return(-1);
+		}
+	}
+
+	while(traceNext(trace, &mode, &address)) {
+		if(mode != 'R' && mode != 'W') {
+			continue;
+		}
+		c = traceCore(trace);
+		if(c >= mc->core_count) {
+			skipped++;
+			continue;
+		}
+		core = &mc->cores[c];
+
+		last = hashMapInsert(last_core, address / (unsigned int)mc->block_size, &added);
+		access.seq = seq++;
+		access.address = address;
+		access.write = (mode == 'W');
+		access.shared = (*last != (unsigned long long)c + 1);
+		*last = (unsigned long long)c + 1;
+
+		if(threads <= 1) {
+			if(!coreFast(mc, core, &access)) {
+				coreEvent(mc, core, &access);
+			}
+			continue;
+		}
+
+		while(core->tail - __atomic_load_n(&core->head, __ATOMIC_ACQUIRE) == MC_RING_SIZE) {
+			sched_yield();
+		}
+		core->ring[core->tail & (MC_RING_SIZE - 1)] = access;
+		__atomic_store_n(&core->tail, core->tail + 1, __ATOMIC_RELEASE);
+		__atomic_store_n(&mc->parser_next, seq, __ATOMIC_RELEASE);
+	}
+	hashMapDestroy(last_core);
+
+	if(threads > 1) {
+		__atomic_store_n(&mc->parser_done, 1, __ATOMIC_RELEASE);
+		for(c = 0; c < mc->core_count; c++) {
+			pthread_join(mc->cores[c].thread, NULL);
+		}
+	}
+
+	return(skipped);
+}
+
+/* multicoreGetStats
+ *
+ * Copies the counters of one core.
+ *
+ * @param	mc				Target multicore
+ * @param	core			Core #
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void multicoreGetStats(Multicore mc, int core, CoreStats *stats) {
+	*stats = mc->cores[core].stats;
+}
+
+/* multicoreGetShared
+ *
+ * Copies the counters of the shared level, or of main memory when
+ * there is no shared level.
+ *
+ * @param	mc				Target multicore
+ * @param	stats			Filled in with the counters
+ *
+ * @return	shared level	1
+ * @return	main memory		0
+ */
+
+int multicoreGetShared(Multicore mc, CacheStats *stats) {
+	if(mc->shared != NULL) {
+		cacheGetStats(mc->shared, stats);
+		return(1);
+	}
+	*stats = mc->memory;
+
+	return(0);
+}
+
+/* END OF FILE */
@@ -0,0 +1,136 @@
+/* Description: Replays a multicore trace through one private cache per
+ *  core, kept coherent with the MESI protocol, in front of an optional
+ *  shared cache level. Private hits run on one thread per core and
+ *  only coherence events take a global lock, in trace order, so the
+ *  results are the same with any number of threads.
+ */
+
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include "cache_sim.h"
+#include "trace.h"
+
+#define MULTICORE_MAX	64
+
+/* Typedefs */
+typedef struct Multicore_* Multicore;
+typedef struct CoreStats_ CoreStats;
+
+/* CoreStats
+ *
+ * Counters of one core after a run.
+ *
+ * @param	accesses		# of accesses made by the core
+ * @param	hits			# of accesses its private cache could serve
+ * @param	misses			# of accesses that had to fetch the block
+ * @param	upgrades		# of writes to shared blocks, which had to
+ *							invalidate the other copies first
+ * @param	invalidations	# of its blocks invalidated by other cores
+ * @param	writebacks		# of dirty blocks it wrote to the level below
+ * @param	transfers		# of misses served from another core's cache
+ */
+
+struct CoreStats_ {
+	long long accesses;
+	long long hits;
+	long long misses;
+	long long upgrades;
+	long long invalidations;
+	long long writebacks;
+	long long transfers;
+};
+
+/* multicoreCreate
+ *
+ * Creates the private caches of every core. Returns NULL on failure.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cores			Number of cores, at most MULTICORE_MAX
+ * @param	cache_size		Size of each private cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity of the private caches
+ * @param	rep_policy		One of the CACHE_ policy numbers, except OPT
+ *
+ * @return	success			multicore
+ * @return	failure			NULL
+ */
+
+Multicore multicoreCreate(long long mm_size, int cores, long long cache_size, int block_size, int nSA,
+	int rep_policy);
+
+/* multicoreDestroy
+ *
+ * Frees a multicore and all of its caches. Passing NULL does nothing.
+ *
+ * @param	mc				Target multicore
+ *
+ * @return	void
+ */
+
+void multicoreDestroy(Multicore mc);
+
+/* multicoreSetShared
+ *
+ * Adds a cache level shared by every core, below the private caches.
+ * Without one, private misses and writebacks go to main memory.
+ *
+ * @param	mc				Target multicore
+ * @param	cache_size		Size of the shared cache in bytes
+ * @param	block_size		Size of each block, same as the private caches
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers, except OPT
+ *
+ * @return	success			NULL
+ * @return	failure			Reason the level cannot be added
+ */
+
+const char *multicoreSetShared(Multicore mc, long long cache_size, int block_size, int nSA,
+	int rep_policy);
+
+/* multicoreRun
+ *
+ * Replays a whole trace. With more than one thread, every core gets
+ * its own thread and the calling thread parses the trace. Accesses
+ * from cores the multicore does not have are skipped.
+ *
+ * @param	mc				Target multicore
+ * @param	trace			Opened trace to replay
+ * @param	threads			1 = Run everything on the calling thread
+ *
+ * @return	success			# of accesses skipped
+ * @return	failure			-1
+ */
+
+long long multicoreRun(Multicore mc, Trace trace, int threads);
+
+/* multicoreGetStats
+ *
+ * Copies the counters of one core.
+ *
+ * @param	mc				Target multicore
+ * @param	core			Core #
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void multicoreGetStats(Multicore mc, int core, CoreStats *stats);
+
+/* multicoreGetShared
+ *
+ * Copies the counters of the shared level, or of main memory when
+ * there is no shared level.
+ *
+ * @param	mc				Target multicore
+ * @param	stats			Filled in with the counters
+ *
+ * @return	shared level	1
+ * @return	main memory		0
+ */
+
+int multicoreGetShared(Multicore mc, CacheStats *stats);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,231 @@
+/* Description: Per-access output of a simulation, as CSV rows or
+ *  fixed size binary records, packed into one large buffer that is
+ *  written out whenever it runs low on room.
+ */
+
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "output.h"
+
+#define OUTPUT_BUFFER_SIZE	(1 << 20)
+#define OUTPUT_RECORD_MAX	64
+
+/* Binary log header: magic, version, and three reserved bytes */
+static const char output_magic[4] = {'C', 'S', 'A', 'L'};
+#define OUTPUT_VERSION		2
+
+/* Structs */
+
+/* Output
+ *
+ * @param	file			File the log goes to
+ * @param	owned			1 if the file was opened here and must be closed
+ * @param	format			OUTPUT_CSV or OUTPUT_BINARY
+ * @param	ok				0 once a write has failed
+ * @param	used			Bytes of buffer filled so far
+ * @param	buffer			Records waiting to be written
+ */
+
+struct Output_ {
+	FILE *file;
+	int owned;
+	int format;
+	int ok;
+	int used;
+	char buffer[OUTPUT_BUFFER_SIZE];
+};
+
+/* outputFlush
+ *
+ * Writes the whole buffer to the file and empties it.
+ *
+ * @param	out				Target log
+ *
+ * @return	void
+ */
+
+static void outputFlush(Output out) {
+	if(out->used > 0 && fwrite(out->buffer, 1, out->used, out->file) != (size_t)out->used) {
+		out->ok = 0;
+	}
+	out->used = 0;
+}
+
+/* outputNumber
+ *
+ * Adds an unsigned number to the buffer in decimal, without printf.
+ *
+ * @param	out				Target log
+ * @param	n				Number to add
+ *
+ * @return	void
+ */
+
+static inline void outputNumber(Output out, unsigned long long n) {
+	char digits[20];
+	int i = 0;
+
+	do {
+		digits[i++] = (char)('0' + n % 10);
+		n /= 10;
+	} while(n != 0);
+	while(i > 0) {
+		out->buffer[out->used++] = digits[--i];
+	}
+}
+
+/* outputWord
+ *
+ * Adds a 32 bit number to the buffer, little endian.
+ *
+ * @param	out				Target log
+ * @param	n				Number to add
+ *
+ * @return	void
+ */
+
+static inline void outputWord(Output out, unsigned int n) {
+	out->buffer[out->used++] = (char)(n & 0xff);
+	out->buffer[out->used++] = (char)((n >> 8) & 0xff);
+	out->buffer[out->used++] = (char)((n >> 16) & 0xff);
+	out->buffer[out->used++] = (char)((n >> 24) & 0xff);
+}
+
+/* outputOpen
+ *
+ * Opens a per-access log and writes its header. A CSV log starts with
+ * a row of column names, index,mode,address,block,set,hit. A binary
+ * log starts with the 8 bytes "CSAL", version 2, and three reserved
+ * bytes, then has 13 bytes per access: the address as a 64 bit and
+ * the set as a 32 bit little endian number, and a byte with bit 0 set
+ * for writes and bit 1 for hits. Returns NULL on failure.
+ *
+ * @param	path			File to write, NULL or - for stdout
+ * @param	format			OUTPUT_CSV or OUTPUT_BINARY
+ *
+ * @return	success			output
+ * @return	failure			NULL
+ */
+
+Output outputOpen(const char *path, int format) {
+	Output out;
+	static const char columns[] = "index,mode,address,block,set,hit\n";
+
+	if(format != OUTPUT_CSV && format != OUTPUT_BINARY) {
+		return NULL;
+	}
+
+	out = (Output) malloc(sizeof(struct Output_));
+	if(out == NULL) {
+		return NULL;
+	}
+
+	if(path == NULL || strcmp(path, "-") == 0) {
+		out->file = stdout;
+		out->owned = 0;
+	}
+	else {
+		out->file = fopen(path, (format == OUTPUT_BINARY) ? "wb" : "w");
+		out->owned = 1;
+		if(out->file == NULL) {
+			free(out);
+			return NULL;
+		}
+	}
+	out->format = format;
+	out->ok = 1;
+	out->used = 0;
+
+	if(format == OUTPUT_CSV) {
+		memcpy(out->buffer, columns, sizeof(columns) - 1);
+		out->used = sizeof(columns) - 1;
+	}
+	else {
+		memcpy(out->buffer, output_magic, sizeof(output_magic));
+		out->buffer[4] = OUTPUT_VERSION;
+		out->buffer[5] = 0;
+		out->buffer[6] = 0;
+		out->buffer[7] = 0;
+		out->used = 8;
+	}
+
+	return(out);
+}
+
+/* outputClose
+ *
+ * Writes out what is left in the buffer and closes the log. Passing
+ * NULL does nothing.
+ *
+ * @param	out				Target log
+ *
+ * @return	success			1
+ * @return	write error		0
+ */
+
+int outputClose(Output out) {
+	int ok;
+
+	if(out == NULL) {
+		return(1);
+	}
+
+	outputFlush(out);
+	if(fflush(out->file) != 0) {
+		out->ok = 0;
+	}
+	if(out->owned && fclose(out->file) != 0) {
+		out->ok = 0;
+	}
+	ok = out->ok;
+	free(out);
+
+	return(ok);
+}
+
+/* outputAccess
+ *
+ * Adds one access to the log.
+ *
+ * @param	out				Target log
+ * @param	index			Position of the access in the trace
+ * @param	write			0 = Read, 1 = Write
+ * @param	address			Main memory address
+ * @param	block			Main memory block #
+ * @param	set				Cache set #
+ * @param	hit				1 = Hit, 0 = Miss
+ *
+ * @return	void
+ */
+
+void outputAccess(Output out, unsigned long long index, int write, unsigned long long address,
+	unsigned long long block, int set, int hit) {
+	if(out->used > OUTPUT_BUFFER_SIZE - OUTPUT_RECORD_MAX) {
+		outputFlush(out);
+	}
+
+	if(out->format == OUTPUT_CSV) {
+		outputNumber(out, index);
+		out->buffer[out->used++] = ',';
+		out->buffer[out->used++] = write ? 'W' : 'R';
+		out->buffer[out->used++] = ',';
+		outputNumber(out, address);
+		out->buffer[out->used++] = ',';
+		outputNumber(out, block);
+		out->buffer[out->used++] = ',';
+		outputNumber(out, (unsigned int)set);
+		out->buffer[out->used++] = ',';
+		out->buffer[out->used++] = hit ? '1' : '0';
+		out->buffer[out->used++] = '\n';
+	}
+	else {
+		outputWord(out, (unsigned int)address);
+		outputWord(out, (unsigned int)(address >> 32));
+		outputWord(out, (unsigned int)set);
+		out->buffer[out->used++] = (char)((write ? 1 : 0) | (hit ? 2 : 0));
+	}
+}
+
+/* END OF FILE */
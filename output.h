@@ -0,0 +1,70 @@
+/* Description: Per-access output of a simulation. Records are packed
+ *  into a large buffer with hand-rolled number formatting and written
+ *  out in big blocks, so logging every access of a long trace costs
+ *  little next to simulating it.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+/* Output formats */
+#define OUTPUT_SUMMARY	0
+#define OUTPUT_NONE		1
+#define OUTPUT_CSV		2
+#define OUTPUT_BINARY	3
+
+/* Typedefs */
+typedef struct Output_* Output;
+
+/* outputOpen
+ *
+ * Opens a per-access log and writes its header. A CSV log starts with
+ * a row of column names, index,mode,address,block,set,hit. A binary
+ * log starts with the 8 bytes "CSAL", version 2, and three reserved
+ * bytes, then has 13 bytes per access: the address as a 64 bit and
+ * the set as a 32 bit little endian number, and a byte with bit 0 set
+ * for writes and bit 1 for hits. Returns NULL on failure.
+ *
+ * @param	path			File to write, NULL or - for stdout
+ * @param	format			OUTPUT_CSV or OUTPUT_BINARY
+ *
+ * @return	success			output
+ * @return	failure			NULL
+ */
+
+Output outputOpen(const char *path, int format);
+
+/* outputClose
+ *
+ * Writes out what is left in the buffer and closes the log. Passing
+ * NULL does nothing.
+ *
+ * @param	out				Target log
+ *
+ * @return	success			1
+ * @return	write error		0
+ */
+
+int outputClose(Output out);
+
+/* outputAccess
+ *
+ * Adds one access to the log.
+ *
+ * @param	out				Target log
+ * @param	index			Position of the access in the trace
+ * @param	write			0 = Read, 1 = Write
+ * @param	address			Main memory address
+ * @param	block			Main memory block #
+ * @param	set				Cache set #
+ * @param	hit				1 = Hit, 0 = Miss
+ *
+ * @return	void
+ */
+
+void outputAccess(Output out, unsigned long long index, int write, unsigned long long address,
+	unsigned long long block, int set, int hit);
+
+#endif
+
+/* END OF FILE */
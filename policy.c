@@ -0,0 +1,652 @@
+/* Description: Replacement policies of a cache. LRU, FIFO, and LFU
+ *  keep one 32 bit word per block, OPT one 64 bit next use per block,
+ *  SRRIP and BRRIP one byte per block, tree-PLRU one bit per way, and
+ *  Random one seed per set.
+ *  Random and BRRIP draw from a generator of their own in every set,
+ *  so results only depend on the accesses made to that set.
+ */
+
+/* Libraries */
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cache_sim.h"
+#include "policy.h"
+
+/* Metadata each policy needs */
+#define POLICY_STAMPS	1
+#define POLICY_RRPV		2
+#define POLICY_TREE		4
+#define POLICY_SEEDS	8
+#define POLICY_NEXT		16
+
+/* Re-reference predictions of SRRIP and BRRIP, 2 bits each */
+#define RRPV_NEAR		0
+#define RRPV_LONG		2
+#define RRPV_DISTANT	3
+
+/* BRRIP inserts with a long prediction once every this many fills */
+#define BRRIP_CHANCE	32
+
+/* Structs */
+
+/* PolicyOps
+ *
+ * Hooks and needs of one replacement policy.
+ *
+ * @param	name			Name of the policy
+ * @param	needs			POLICY_ flags of the metadata it uses
+ * @param	insert			Called when a block is put into a way
+ * @param	hit				Called when a way is hit
+ * @param	victim			Picks the way of a full set to replace
+ */
+
+struct PolicyOps_ {
+	const char *name;
+	int needs;
+	void (*insert)(Policy policy, int set, int way, unsigned long long next_use);
+	void (*hit)(Policy policy, int set, int way, unsigned long long next_use);
+	int (*victim)(Policy policy, int set);
+};
+
+/* Policy
+ *
+ * Only the arrays named in the needs of the policy are allocated.
+ *
+ * @param	ops				Hooks of the policy
+ * @param	set_count		Number of sets
+ * @param	nSA				Number of ways in each set
+ * @param	tree_size		nSA rounded up to a power of 2, the leaves of
+ *							the PLRU tree
+ * @param	tree_words		64 bit words of PLRU bits in each set
+ * @param	clock			Last stamp handed out, renumbered before it
+ *							wraps
+ * @param	stamps			LRU or FIFO stamp, or LFU count of each block
+ * @param	next_uses		OPT next use of each block
+ * @param	rrpv			Re-reference prediction of each block
+ * @param	tree			PLRU bits of each set, node n of the tree is
+ *							bit n and points at the colder half
+ * @param	seeds			Random number state of each set
+ */
+
+struct Policy_ {
+	const struct PolicyOps_ *ops;
+	int set_count;
+	int nSA;
+	int tree_size;
+	int tree_words;
+	unsigned int clock;
+	unsigned int *stamps;
+	unsigned long long *next_uses;
+	unsigned char *rrpv;
+	unsigned long long *tree;
+	unsigned int *seeds;
+};
+
+/* policyRandom
+ *
+ * Steps the xorshift generator of a set.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ *
+ * @return	value			Next random number of the set
+ */
+
+static inline unsigned int policyRandom(Policy policy, int set) {
+	unsigned int x = policy->seeds[set];
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	policy->seeds[set] = x;
+
+	return(x);
+}
+
+/* stampMin
+ *
+ * Finds the first way of a set with the smallest stamp.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ *
+ * @return	way				Way # inside the set
+ */
+
+static int stampMin(Policy policy, int set) {
+	const unsigned int *stamps = policy->stamps + (long)set * policy->nSA;
+	int i, way = 0;
+
+	for(i = 1; i < policy->nSA; i++) {
+		if(stamps[i] < stamps[way]) {
+			way = i;
+		}
+	}
+
+	return(way);
+}
+
+/* stampCompare
+ *
+ * Orders stamps packed above their way # by qsort.
+ */
+
+static int stampCompare(const void *a, const void *b) {
+	unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+
+	return((x > y) - (x < y));
+}
+
+/* stampRenumber
+ *
+ * Replaces the stamps of every set by their rank inside the set, so
+ * the clock can start again from nSA without changing any order.
+ * Unstamped ways stay 0. Runs once every 4G stamps.
+ *
+ * @param	policy			Target policy
+ *
+ * @return	void
+ */
+
+static void stampRenumber(Policy policy) {
+	unsigned long long *order;
+	unsigned int *stamps, rank;
+	int set, i;
+
+	order = (unsigned long long *) malloc(sizeof(unsigned long long) * policy->nSA);
+	assert(order != NULL);
+	for(set = 0; set < policy->set_count; set++) {
+		stamps = policy->stamps + (long)set * policy->nSA;
+		for(i = 0; i < policy->nSA; i++) {
+			order[i] = ((unsigned long long)stamps[i] << 32) | (unsigned int)i;
+		}
+		qsort(order, policy->nSA, sizeof(unsigned long long), stampCompare);
+		rank = 0;
+		for(i = 0; i < policy->nSA; i++) {
+			if((order[i] >> 32) != 0) {
+				stamps[order[i] & 0xffffffffu] = ++rank;
+			}
+		}
+	}
+	free(order);
+	policy->clock = (unsigned int)policy->nSA;
+}
+
+/* LRU and FIFO
+ *
+ * Both stamp a block from the clock when it is put in and evict the
+ * oldest stamp. LRU stamps it again on every hit.
+ */
+
+static void lruTouch(Policy policy, int set, int way, unsigned long long next_use) {
+	if(policy->clock == UINT_MAX) {
+		stampRenumber(policy);
+	}
+	policy->stamps[(long)set * policy->nSA + way] = ++policy->clock;
+}
+
+static void fifoHit(Policy policy, int set, int way, unsigned long long next_use) {
+	return;
+}
+
+/* OPT
+ *
+ * Keeps the next use of each block and evicts the furthest one.
+ */
+
+static void optTouch(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->next_uses[(long)set * policy->nSA + way] = next_use;
+}
+
+static int optVictim(Policy policy, int set) {
+	const unsigned long long *next_uses = policy->next_uses + (long)set * policy->nSA;
+	int i, way = 0;
+
+	for(i = 1; i < policy->nSA; i++) {
+		if(next_uses[i] > next_uses[way]) {
+			way = i;
+		}
+	}
+
+	return(way);
+}
+
+/* Random
+ *
+ * Evicts any way of the set with the same chance.
+ */
+
+static void randomTouch(Policy policy, int set, int way, unsigned long long next_use) {
+	return;
+}
+
+static int randomVictim(Policy policy, int set) {
+	return((int)(policyRandom(policy, set) % (unsigned int)policy->nSA));
+}
+
+/* Tree-PLRU
+ *
+ * A binary tree over the ways of a set. Using a way turns every node
+ * on its path to point away from it, and the victim is found by
+ * following the pointers from the root. When nSA is not a power of 2
+ * the missing leaves are skipped.
+ */
+
+static void plruTouch(Policy policy, int set, int way, unsigned long long next_use) {
+	unsigned long long *bits = policy->tree + (long)set * policy->tree_words;
+	int node = 1, low = 0, half = policy->tree_size / 2;
+
+	while(half > 0) {
+		if(way < low + half) {
+			bits[node >> 6] |= 1ull << (node & 63);
+			node = 2 * node;
+		}
+		else {
+			bits[node >> 6] &= ~(1ull << (node & 63));
+			node = 2 * node + 1;
+			low += half;
+		}
+		half /= 2;
+	}
+}
+
+static int plruVictim(Policy policy, int set) {
+	const unsigned long long *bits = policy->tree + (long)set * policy->tree_words;
+	int node = 1, low = 0, half = policy->tree_size / 2;
+
+	while(half > 0) {
+		if(((bits[node >> 6] >> (node & 63)) & 1) && low + half < policy->nSA) {
+			node = 2 * node + 1;
+			low += half;
+		}
+		else {
+			node = 2 * node;
+		}
+		half /= 2;
+	}
+
+	return(low);
+}
+
+/* LFU
+ *
+ * Counts the uses of each block since it was put in and evicts the
+ * least used one, the first one on a tie. Counts stop at 4G.
+ */
+
+static void lfuInsert(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->stamps[(long)set * policy->nSA + way] = 1;
+}
+
+static void lfuHit(Policy policy, int set, int way, unsigned long long next_use) {
+	unsigned int *count = &policy->stamps[(long)set * policy->nSA + way];
+
+	if(*count != UINT_MAX) {
+		(*count)++;
+	}
+}
+
+/* SRRIP and BRRIP
+ *
+ * Each block carries a 2 bit guess of how far off its next use is. A
+ * hit makes it near. SRRIP puts new blocks in as long, BRRIP mostly as
+ * distant so that blocks used only once leave quickly. The victim is
+ * the first distant block, after ageing the whole set until there is
+ * one.
+ */
+
+static void srripInsert(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->rrpv[(long)set * policy->nSA + way] = RRPV_LONG;
+}
+
+static void brripInsert(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->rrpv[(long)set * policy->nSA + way] =
+		(policyRandom(policy, set) % BRRIP_CHANCE == 0) ? RRPV_LONG : RRPV_DISTANT;
+}
+
+static void rripHit(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->rrpv[(long)set * policy->nSA + way] = RRPV_NEAR;
+}
+
+static int rripVictim(Policy policy, int set) {
+	unsigned char *rrpv = policy->rrpv + (long)set * policy->nSA;
+	int i, way = 0;
+	unsigned char age;
+
+	for(i = 1; i < policy->nSA; i++) {
+		if(rrpv[i] > rrpv[way]) {
+			way = i;
+		}
+	}
+	age = RRPV_DISTANT - rrpv[way];
+	if(age > 0) {
+		for(i = 0; i < policy->nSA; i++) {
+			rrpv[i] += age;
+		}
+	}
+
+	return(way);
+}
+
+/* Hooks of each policy, by policy number */
+static const struct PolicyOps_ policies[] = {
+	{ NULL, 0, NULL, NULL, NULL },
+	{ "LRU", POLICY_STAMPS, lruTouch, lruTouch, stampMin },
+	{ "FIFO", POLICY_STAMPS, lruTouch, fifoHit, stampMin },
+	{ "OPT", POLICY_NEXT, optTouch, optTouch, optVictim },
+	{ "Random", POLICY_SEEDS, randomTouch, randomTouch, randomVictim },
+	{ "PLRU", POLICY_TREE, plruTouch, plruTouch, plruVictim },
+	{ "LFU", POLICY_STAMPS, lfuInsert, lfuHit, stampMin },
+	{ "SRRIP", POLICY_RRPV, srripInsert, rripHit, rripVictim },
+	{ "BRRIP", POLICY_RRPV | POLICY_SEEDS, brripInsert, rripHit, rripVictim }
+};
+
+#define POLICY_COUNT	((int)(sizeof(policies) / sizeof(policies[0])))
+
+/* policyCreate
+ *
+ * Creates the metadata of a policy for a cache with the given number
+ * of sets and ways. Returns NULL for an unknown policy.
+ *
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	set_count		Number of sets
+ * @param	nSA				Number of ways in each set
+ *
+ * @return	success			policy
+ * @return	failure			NULL
+ */
+
+Policy policyCreate(int rep_policy, int set_count, int nSA) {
+	Policy policy;
+	long blocks;
+
+	if(rep_policy <= 0 || rep_policy >= POLICY_COUNT) {
+		return(NULL);
+	}
+
+	policy = (Policy) malloc(sizeof(struct Policy_));
+	assert(policy != NULL);
+
+	policy->ops = &policies[rep_policy];
+	policy->set_count = set_count;
+	policy->nSA = nSA;
+	policy->clock = 0;
+	policy->stamps = NULL;
+	policy->next_uses = NULL;
+	policy->rrpv = NULL;
+	policy->tree = NULL;
+	policy->seeds = NULL;
+
+	policy->tree_size = 1;
+	while(policy->tree_size < nSA) {
+		policy->tree_size *= 2;
+	}
+	policy->tree_words = (policy->tree_size + 63) / 64;
+
+	blocks = (long)set_count * nSA;
+	if(policy->ops->needs & POLICY_STAMPS) {
+		policy->stamps = (unsigned int *) calloc(blocks, sizeof(unsigned int));
+		assert(policy->stamps != NULL);
+	}
+	if(policy->ops->needs & POLICY_NEXT) {
+		policy->next_uses = (unsigned long long *) calloc(blocks, sizeof(unsigned long long));
+		assert(policy->next_uses != NULL);
+	}
+	if(policy->ops->needs & POLICY_RRPV) {
+		policy->rrpv = (unsigned char *) calloc(blocks, sizeof(unsigned char));
+		assert(policy->rrpv != NULL);
+	}
+	if(policy->ops->needs & POLICY_TREE) {
+		policy->tree = (unsigned long long *) calloc((long)set_count * policy->tree_words,
+			sizeof(unsigned long long));
+		assert(policy->tree != NULL);
+	}
+	if(policy->ops->needs & POLICY_SEEDS) {
+		policy->seeds = (unsigned int *) malloc(set_count * sizeof(unsigned int));
+		assert(policy->seeds != NULL);
+		policySeed(policy, 0, 1);
+	}
+
+	return(policy);
+}
+
+/* policyDestroy
+ *
+ * Frees a policy. Passing NULL does nothing.
+ *
+ * @param	policy			Target policy
+ *
+ * @return	void
+ */
+
+void policyDestroy(Policy policy) {
+	if(policy != NULL) {
+		free(policy->stamps);
+		free(policy->next_uses);
+		free(policy->rrpv);
+		free(policy->tree);
+		free(policy->seeds);
+		free(policy);
+	}
+
+	return;
+}
+
+/* policySeed
+ *
+ * Seeds the random number state of every set, for the policies that
+ * have one, as if set i were set first + i * stride of a bigger cache.
+ * policyCreate seeds with first = 0 and stride = 1.
+ *
+ * @param	policy			Target policy
+ * @param	first			Set # of set 0 in the bigger cache
+ * @param	stride			Distance in the bigger cache between sets
+ *
+ * @return	void
+ */
+
+void policySeed(Policy policy, int first, int stride) {
+	unsigned int set;
+	int i;
+
+	if(policy->seeds == NULL) {
+		return;
+	}
+	for(i = 0; i < policy->set_count; i++) {
+		set = (unsigned int)first + (unsigned int)i * (unsigned int)stride;
+		policy->seeds[i] = (set + 1) * 2654435761u | 1;
+	}
+}
+
+/* policyInsert
+ *
+ * Tells the policy a new block was put into a way.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ * @param	way				Way # inside the set
+ * @param	next_use		Index of the next access to the block, for OPT
+ *
+ * @return	void
+ */
+
+void policyInsert(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->ops->insert(policy, set, way, next_use);
+}
+
+/* policyHit
+ *
+ * Tells the policy the block in a way was used again.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ * @param	way				Way # inside the set
+ * @param	next_use		Index of the next access to the block, for OPT
+ *
+ * @return	void
+ */
+
+void policyHit(Policy policy, int set, int way, unsigned long long next_use) {
+	policy->ops->hit(policy, set, way, next_use);
+}
+
+/* policyVictim
+ *
+ * Picks the way of a full set to replace.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ *
+ * @return	way				Way # inside the set
+ */
+
+int policyVictim(Policy policy, int set) {
+	return(policy->ops->victim(policy, set));
+}
+
+/* policyFootprint
+ *
+ * Works out how many bytes of host memory the metadata of a policy
+ * takes up.
+ *
+ * @param	policy			Target policy
+ *
+ * @return	bytes			Bytes used by the metadata arrays
+ */
+
+long policyFootprint(Policy policy) {
+	long blocks, bytes = 0;
+
+	blocks = (long)policy->set_count * policy->nSA;
+	if(policy->stamps != NULL) {
+		bytes += blocks * (long)sizeof(unsigned int);
+	}
+	if(policy->next_uses != NULL) {
+		bytes += blocks * (long)sizeof(unsigned long long);
+	}
+	if(policy->rrpv != NULL) {
+		bytes += blocks * (long)sizeof(unsigned char);
+	}
+	if(policy->tree != NULL) {
+		bytes += (long)policy->set_count * policy->tree_words * (long)sizeof(unsigned long long);
+	}
+	if(policy->seeds != NULL) {
+		bytes += (long)policy->set_count * (long)sizeof(unsigned int);
+	}
+
+	return(bytes);
+}
+
+/* policySave
+ *
+ * Writes the metadata of a policy to a file as it is held in memory:
+ * the clock, then each of its arrays in turn. policyFootprint plus
+ * POLICY_SAVE_HEADER bytes are written.
+ *
+ * @param	policy			Target policy
+ * @param	file			File to write to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int policySave(Policy policy, FILE *file) {
+	long blocks;
+	int ok;
+
+	blocks = (long)policy->set_count * policy->nSA;
+	ok = (fwrite(&policy->clock, sizeof(policy->clock), 1, file) == 1);
+	if(ok && policy->stamps != NULL) {
+		ok = (fwrite(policy->stamps, sizeof(unsigned int), blocks, file) == (size_t)blocks);
+	}
+	if(ok && policy->next_uses != NULL) {
+		ok = (fwrite(policy->next_uses, sizeof(unsigned long long), blocks, file)
+			== (size_t)blocks);
+	}
+	if(ok && policy->rrpv != NULL) {
+		ok = (fwrite(policy->rrpv, sizeof(unsigned char), blocks, file) == (size_t)blocks);
+	}
+	if(ok && policy->tree != NULL) {
+		blocks = (long)policy->set_count * policy->tree_words;
+		ok = (fwrite(policy->tree, sizeof(unsigned long long), blocks, file) == (size_t)blocks);
+	}
+	if(ok && policy->seeds != NULL) {
+		ok = (fwrite(policy->seeds, sizeof(unsigned int), policy->set_count, file)
+			== (size_t)policy->set_count);
+	}
+
+	return(ok);
+}
+
+/* policyRestore
+ *
+ * Reads back metadata written by policySave for a policy of the same
+ * number and shape.
+ *
+ * @param	policy			Target policy
+ * @param	data			Saved metadata
+ * @param	size			Bytes of saved metadata
+ *
+ * @return	success			1
+ * @return	wrong size		0
+ */
+
+int policyRestore(Policy policy, const unsigned char *data, long size) {
+	long blocks, bytes;
+
+	if(size != POLICY_SAVE_HEADER + policyFootprint(policy)) {
+		return(0);
+	}
+
+	blocks = (long)policy->set_count * policy->nSA;
+	memcpy(&policy->clock, data, sizeof(policy->clock));
+	data += sizeof(policy->clock);
+	if(policy->stamps != NULL) {
+		bytes = blocks * (long)sizeof(unsigned int);
+		memcpy(policy->stamps, data, bytes);
+		data += bytes;
+	}
+	if(policy->next_uses != NULL) {
+		bytes = blocks * (long)sizeof(unsigned long long);
+		memcpy(policy->next_uses, data, bytes);
+		data += bytes;
+	}
+	if(policy->rrpv != NULL) {
+		bytes = blocks * (long)sizeof(unsigned char);
+		memcpy(policy->rrpv, data, bytes);
+		data += bytes;
+	}
+	if(policy->tree != NULL) {
+		bytes = (long)policy->set_count * policy->tree_words * (long)sizeof(unsigned long long);
+		memcpy(policy->tree, data, bytes);
+		data += bytes;
+	}
+	if(policy->seeds != NULL) {
+		bytes = (long)policy->set_count * (long)sizeof(unsigned int);
+		memcpy(policy->seeds, data, bytes);
+	}
+
+	return(1);
+}
+
+/* policyName
+ *
+ * Gives the name of a replacement policy.
+ *
+ * @param	rep_policy		Replacement policy number
+ *
+ * @return	known			Name of the policy, such as "LRU"
+ * @return	unknown			NULL
+ */
+
+const char *policyName(int rep_policy) {
+	if(rep_policy <= 0 || rep_policy >= POLICY_COUNT) {
+		return(NULL);
+	}
+
+	return(policies[rep_policy].name);
+}
+
+/* END OF FILE */
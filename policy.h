@@ -0,0 +1,156 @@
+/* Description: Replacement policies of a cache. Each policy keeps its
+ *  own metadata for every set and is driven by three hooks: a block
+ *  was put into a way, a way was hit, and a full set needs a victim.
+ *  Every hook touches only the set it is given and takes O(assoc) time
+ *  or better.
+ */
+
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdio.h>
+
+/* Bytes policySave writes ahead of the metadata arrays: the clock */
+#define POLICY_SAVE_HEADER	4
+
+/* Typedefs */
+typedef struct Policy_* Policy;
+
+/* policyCreate
+ *
+ * Creates the metadata of a policy for a cache with the given number
+ * of sets and ways. Returns NULL for an unknown policy.
+ *
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	set_count		Number of sets
+ * @param	nSA				Number of ways in each set
+ *
+ * @return	success			policy
+ * @return	failure			NULL
+ */
+
+Policy policyCreate(int rep_policy, int set_count, int nSA);
+
+/* policyDestroy
+ *
+ * Frees a policy. Passing NULL does nothing.
+ *
+ * @param	policy			Target policy
+ *
+ * @return	void
+ */
+
+void policyDestroy(Policy policy);
+
+/* policySeed
+ *
+ * Seeds the random number state of every set, for the policies that
+ * have one, as if set i were set first + i * stride of a bigger cache.
+ * policyCreate seeds with first = 0 and stride = 1.
+ *
+ * @param	policy			Target policy
+ * @param	first			Set # of set 0 in the bigger cache
+ * @param	stride			Distance in the bigger cache between sets
+ *
+ * @return	void
+ */
+
+void policySeed(Policy policy, int first, int stride);
+
+/* policyInsert
+ *
+ * Tells the policy a new block was put into a way.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ * @param	way				Way # inside the set
+ * @param	next_use		Index of the next access to the block, for OPT
+ *
+ * @return	void
+ */
+
+void policyInsert(Policy policy, int set, int way, unsigned long long next_use);
+
+/* policyHit
+ *
+ * Tells the policy the block in a way was used again.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ * @param	way				Way # inside the set
+ * @param	next_use		Index of the next access to the block, for OPT
+ *
+ * @return	void
+ */
+
+void policyHit(Policy policy, int set, int way, unsigned long long next_use);
+
+/* policyVictim
+ *
+ * Picks the way of a full set to replace.
+ *
+ * @param	policy			Target policy
+ * @param	set				Cache set #
+ *
+ * @return	way				Way # inside the set
+ */
+
+int policyVictim(Policy policy, int set);
+
+/* policyFootprint
+ *
+ * Works out how many bytes of host memory the metadata of a policy
+ * takes up.
+ *
+ * @param	policy			Target policy
+ *
+ * @return	bytes			Bytes used by the metadata arrays
+ */
+
+long policyFootprint(Policy policy);
+
+/* policySave
+ *
+ * Writes the metadata of a policy to a file as it is held in memory:
+ * the clock, then each of its arrays in turn. policyFootprint plus
+ * POLICY_SAVE_HEADER bytes are written.
+ *
+ * @param	policy			Target policy
+ * @param	file			File to write to
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int policySave(Policy policy, FILE *file);
+
+/* policyRestore
+ *
+ * Reads back metadata written by policySave for a policy of the same
+ * number and shape.
+ *
+ * @param	policy			Target policy
+ * @param	data			Saved metadata
+ * @param	size			Bytes of saved metadata
+ *
+ * @return	success			1
+ * @return	wrong size		0
+ */
+
+int policyRestore(Policy policy, const unsigned char *data, long size);
+
+/* policyName
+ *
+ * Gives the name of a replacement policy.
+ *
+ * @param	rep_policy		Replacement policy number
+ *
+ * @return	known			Name of the policy, such as "LRU"
+ * @return	unknown			NULL
+ */
+
+const char *policyName(int rep_policy);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,322 @@
+/* Description: Detailed statistics of one cache. Per-set counters and
+ *  the fill time of every block are fixed arrays. Reuse distances and
+ *  hot blocks follow main memory blocks through a fixed two-way table
+ *  of PROFILE_HISTORY entries per cache block, so its size never
+ *  depends on the trace. A block that loses its entry to a busier one
+ *  starts over as untracked the next time it is used.
+ */
+
+/* Libraries */
+#include <stdlib.h>
+#include <string.h>
+#include "profile.h"
+
+/* Block history entries per cache block, and the fewest to keep */
+#define PROFILE_HISTORY		16
+#define PROFILE_HISTORY_MIN	65536
+
+/* Structs */
+
+/* ProfileEntry
+ *
+ * History of one main memory block.
+ *
+ * @param	block			Main memory block # + 1, 0 for an empty entry
+ * @param	last_use		Access # the block was last used at
+ * @param	uses			# of accesses to the block
+ */
+
+struct ProfileEntry_ {
+	unsigned long long block;
+	unsigned long long last_use;
+	unsigned long long uses;
+};
+
+/* Profile
+ *
+ * @param	set_count		Number of sets
+ * @param	block_count		Number of cache blocks
+ * @param	clock			Number of accesses so far
+ * @param	fill_times		Access # each cache block was last filled at
+ * @param	set_accesses	# of accesses to each set
+ * @param	set_misses		# of misses in each set
+ * @param	set_evictions	# of valid blocks evicted from each set
+ * @param	eviction_age	Histogram of how long evicted blocks were held
+ * @param	reuse			Histogram of accesses between uses of a block
+ * @param	untracked		# of accesses to blocks with no history
+ * @param	history_bits	log2 of the number of history pairs
+ * @param	history			Block history, two entries per pair
+ */
+
+struct Profile_ {
+	int set_count;
+	int block_count;
+	unsigned long long clock;
+	unsigned long long *fill_times;
+	unsigned long long *set_accesses;
+	unsigned long long *set_misses;
+	unsigned long long *set_evictions;
+	unsigned long long eviction_age[PROFILE_BUCKETS];
+	unsigned long long reuse[PROFILE_BUCKETS];
+	unsigned long long untracked;
+	int history_bits;
+	struct ProfileEntry_ *history;
+};
+
+/* profileBucket
+ *
+ * Gives the histogram bucket of a value: the number of bits it needs.
+ *
+ * @param	value			Value to place
+ *
+ * @return	bucket			0 to PROFILE_BUCKETS - 1
+ */
+
+static inline int profileBucket(unsigned long long value) {
+	return((value == 0) ? 0 : 64 - __builtin_clzll(value));
+}
+
+/* profileCreate
+ *
+ * Creates an empty profile for a cache. Returns NULL on failure.
+ *
+ * @param	set_count		Number of sets of the cache
+ * @param	block_count		Number of blocks of the cache
+ *
+ * @return	success			profile
+ * @return	failure			NULL
+ */
+
+Profile profileCreate(int set_count, int block_count) {
+	Profile profile;
+	long entries;
+
+	profile = (Profile) calloc(1, sizeof(struct Profile_));
+	if(profile == NULL) {
+		return NULL;
+	}
+	profile->set_count = set_count;
+	profile->block_count = block_count;
+	entries = (long)block_count * PROFILE_HISTORY;
+	if(entries < PROFILE_HISTORY_MIN) {
+		entries = PROFILE_HISTORY_MIN;
+	}
+	while((2L << profile->history_bits) < entries) {
+		profile->history_bits++;
+	}
+
+	profile->fill_times = (unsigned long long *) calloc(block_count, sizeof(unsigned long long));
+	profile->set_accesses = (unsigned long long *) calloc(set_count, sizeof(unsigned long long));
+	profile->set_misses = (unsigned long long *) calloc(set_count, sizeof(unsigned long long));
+	profile->set_evictions = (unsigned long long *) calloc(set_count, sizeof(unsigned long long));
+	profile->history = (struct ProfileEntry_ *) calloc(2L << profile->history_bits,
+		sizeof(struct ProfileEntry_));
+	if(profile->fill_times == NULL || profile->set_accesses == NULL || profile->set_misses == NULL
+		|| profile->set_evictions == NULL || profile->history == NULL) {
+		profileDestroy(profile);
+		return NULL;
+	}
+
+	return(profile);
+}
+
+/* profileDestroy
+ *
+ * Frees a profile. Passing NULL does nothing.
+ *
+ * @param	profile			Target profile
+ *
+ * @return	void
+ */
+
+void profileDestroy(Profile profile) {
+	if(profile != NULL) {
+		free(profile->fill_times);
+		free(profile->set_accesses);
+		free(profile->set_misses);
+		free(profile->set_evictions);
+		free(profile->history);
+		free(profile);
+	}
+}
+
+/* profileAccess
+ *
+ * Counts one access. Ages and reuse distances are measured in
+ * accesses made to the cache. A block without an entry takes the one
+ * of its pair with fewer uses.
+ *
+ * @param	profile			Target profile
+ * @param	mm_block		Main memory block #
+ * @param	set				Cache set #
+ * @param	block			Cache block # that served the access
+ * @param	hit				1 = Hit, 0 = Miss
+ * @param	evicted			1 if a miss evicted a valid block
+ *
+ * @return	void
+ */
+
+void profileAccess(Profile profile, unsigned long long mm_block, int set, int block, int hit,
+	int evicted) {
+	struct ProfileEntry_ *entry;
+
+	profile->set_accesses[set]++;
+	if(!hit) {
+		profile->set_misses[set]++;
+		if(evicted) {
+			profile->set_evictions[set]++;
+			profile->eviction_age[profileBucket(profile->clock - profile->fill_times[block])]++;
+		}
+		profile->fill_times[block] = profile->clock;
+	}
+
+	entry = &profile->history[((mm_block * 0x9e3779b97f4a7c15ull) >> (63 - profile->history_bits))
+		& ~1ull];
+	if(entry[1].block == mm_block + 1) {
+		entry++;
+	}
+	if(entry->block == mm_block + 1) {
+		profile->reuse[profileBucket(profile->clock - entry->last_use)]++;
+	}
+	else {
+		if(entry[1].uses < entry->uses) {
+			entry++;
+		}
+		entry->block = mm_block + 1;
+		entry->uses = 0;
+		profile->untracked++;
+	}
+	entry->last_use = profile->clock;
+	entry->uses++;
+	profile->clock++;
+}
+
+/* profileHistogram
+ *
+ * Writes a histogram as a JSON array, leaving off the empty buckets
+ * at the end.
+ *
+ * @param	file			File to write to
+ * @param	buckets			Histogram
+ *
+ * @return	void
+ */
+
+static void profileHistogram(FILE *file, const unsigned long long *buckets) {
+	int i, last;
+
+	for(last = PROFILE_BUCKETS; last > 0 && buckets[last - 1] == 0; last--);
+	fprintf(file, "[");
+	for(i = 0; i < last; i++) {
+		fprintf(file, "%s%llu", (i > 0) ? ", " : "", buckets[i]);
+	}
+	fprintf(file, "]");
+}
+
+/* profileArray
+ *
+ * Writes one counter of every set as a JSON array.
+ *
+ * @param	file			File to write to
+ * @param	values			Counter of each set
+ * @param	count			Number of sets
+ *
+ * @return	void
+ */
+
+static void profileArray(FILE *file, const unsigned long long *values, int count) {
+	int i;
+
+	fprintf(file, "[");
+	for(i = 0; i < count; i++) {
+		fprintf(file, "%s%llu", (i > 0) ? ", " : "", values[i]);
+	}
+	fprintf(file, "]");
+}
+
+/* profileTop
+ *
+ * Finds the PROFILE_TOP largest values, keeping the first one of any
+ * tie, and skipping zeros.
+ *
+ * @param	values			Values to pick from
+ * @param	count			Number of values
+ * @param	stride			Distance between values, in values
+ * @param	top				Filled with the indexes of the largest values,
+ *							largest first
+ *
+ * @return	found			Number of indexes filled in
+ */
+
+static int profileTop(const unsigned long long *values, long count, long stride, long *top) {
+	long i;
+	int found = 0, j;
+
+	for(i = 0; i < count; i++) {
+		if(values[i * stride] == 0
+			|| (found == PROFILE_TOP && values[i * stride] <= values[top[found - 1] * stride])) {
+			continue;
+		}
+		if(found < PROFILE_TOP) {
+			found++;
+		}
+		for(j = found - 1; j > 0 && values[top[j - 1] * stride] < values[i * stride]; j--) {
+			top[j] = top[j - 1];
+		}
+		top[j] = i;
+	}
+
+	return(found);
+}
+
+/* profileWrite
+ *
+ * Writes the profile as members of a JSON object that the caller has
+ * opened: "sets", "eviction_age", "reuse_distance", "hot_blocks", and
+ * "thrashing_sets", each followed by a comma.
+ *
+ * @param	profile			Target profile
+ * @param	file			File to write to
+ *
+ * @return	void
+ */
+
+void profileWrite(Profile profile, FILE *file) {
+	long top[PROFILE_TOP];
+	int found, i;
+
+	fprintf(file, "\t\"sets\": {\n\t\t\"accesses\": ");
+	profileArray(file, profile->set_accesses, profile->set_count);
+	fprintf(file, ",\n\t\t\"misses\": ");
+	profileArray(file, profile->set_misses, profile->set_count);
+	fprintf(file, ",\n\t\t\"evictions\": ");
+	profileArray(file, profile->set_evictions, profile->set_count);
+	fprintf(file, "\n\t},\n");
+
+	fprintf(file, "\t\"eviction_age\": ");
+	profileHistogram(file, profile->eviction_age);
+	fprintf(file, ",\n\t\"reuse_distance\": {\"untracked\": %llu, \"buckets\": ",
+		profile->untracked);
+	profileHistogram(file, profile->reuse);
+	fprintf(file, "},\n");
+
+	found = profileTop(&profile->history[0].uses, 2L << profile->history_bits,
+		sizeof(struct ProfileEntry_) / sizeof(unsigned long long), top);
+	fprintf(file, "\t\"hot_blocks\": [");
+	for(i = 0; i < found; i++) {
+		fprintf(file, "%s\n\t\t{\"block\": %llu, \"accesses\": %llu}", (i > 0) ? "," : "",
+			profile->history[top[i]].block - 1, profile->history[top[i]].uses);
+	}
+	fprintf(file, "%s],\n", (found > 0) ? "\n\t" : "");
+
+	found = profileTop(profile->set_evictions, profile->set_count, 1, top);
+	fprintf(file, "\t\"thrashing_sets\": [");
+	for(i = 0; i < found; i++) {
+		fprintf(file, "%s\n\t\t{\"set\": %ld, \"accesses\": %llu, \"misses\": %llu, \"evictions\": %llu}",
+			(i > 0) ? "," : "", top[i], profile->set_accesses[top[i]],
+			profile->set_misses[top[i]], profile->set_evictions[top[i]]);
+	}
+	fprintf(file, "%s],\n", (found > 0) ? "\n\t" : "");
+}
+
+/* END OF FILE */
@@ -0,0 +1,82 @@
+/* Description: Detailed statistics of one cache, gathered as it runs:
+ *  accesses, misses, and evictions of every set, how long evicted
+ *  blocks stayed in the cache, how long blocks go between uses, and
+ *  which blocks and sets are the busiest. Every counter lives in a
+ *  fixed array sized from the cache, so nothing is allocated per
+ *  access, and it can be written out as JSON.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+/* Buckets of the histograms: bucket 0 counts 0, bucket i counts
+ * 2^(i-1) up to 2^i - 1 */
+#define PROFILE_BUCKETS		65
+
+/* Entries of the hot block and thrashing set reports */
+#define PROFILE_TOP			16
+
+/* Typedefs */
+typedef struct Profile_* Profile;
+
+/* profileCreate
+ *
+ * Creates an empty profile for a cache. Returns NULL on failure.
+ *
+ * @param	set_count		Number of sets of the cache
+ * @param	block_count		Number of blocks of the cache
+ *
+ * @return	success			profile
+ * @return	failure			NULL
+ */
+
+Profile profileCreate(int set_count, int block_count);
+
+/* profileDestroy
+ *
+ * Frees a profile. Passing NULL does nothing.
+ *
+ * @param	profile			Target profile
+ *
+ * @return	void
+ */
+
+void profileDestroy(Profile profile);
+
+/* profileAccess
+ *
+ * Counts one access. Ages and reuse distances are measured in
+ * accesses made to the cache.
+ *
+ * @param	profile			Target profile
+ * @param	mm_block		Main memory block #
+ * @param	set				Cache set #
+ * @param	block			Cache block # that served the access
+ * @param	hit				1 = Hit, 0 = Miss
+ * @param	evicted			1 if a miss evicted a valid block
+ *
+ * @return	void
+ */
+
+void profileAccess(Profile profile, unsigned long long mm_block, int set, int block, int hit,
+	int evicted);
+
+/* profileWrite
+ *
+ * Writes the profile as members of a JSON object that the caller has
+ * opened: "sets", "eviction_age", "reuse_distance", "hot_blocks", and
+ * "thrashing_sets", each followed by a comma.
+ *
+ * @param	profile			Target profile
+ * @param	file			File to write to
+ *
+ * @return	void
+ */
+
+void profileWrite(Profile profile, FILE *file);
+
+#endif
+
+/* END OF FILE */
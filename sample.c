@@ -0,0 +1,194 @@
+/* Description: Sampled simulation of one cache, in the style of SMARTS.
+ *  Every unit is one sample of the hit rate. Their mean and variance
+ *  are kept with Welford's method, so nothing is stored per unit, and
+ *  the confidence interval uses the finite population correction, as
+ *  the units are drawn without replacement from every unit sized
+ *  stretch of the trace.
+ */
+
+/* Libraries */
+#include <math.h>
+#include <stdlib.h>
+#include "sample.h"
+
+/* Structs */
+
+/* Sampler
+ *
+ * @param	cache			Cache being simulated
+ * @param	unit			Accesses simulated in detail per period
+ * @param	period			Accesses per period
+ * @param	warm			Accesses warmed before each unit, 0 for all
+ * @param	position		Position of the next access in its period
+ * @param	unit_hits		# of hits so far in the current unit
+ * @param	mean			Mean hit rate of the whole units
+ * @param	m2				Sum of squared differences from the mean
+ * @param	stats			Counters, filled in as the trace runs
+ */
+
+struct Sampler_ {
+	Cache cache;
+	long long unit;
+	long long period;
+	long long warm;
+	long long position;
+	long long unit_hits;
+	double mean;
+	double m2;
+	SampleStats stats;
+};
+
+/* samplerUnit
+ *
+ * Adds the hit rate of a finished unit to the running mean and
+ * variance.
+ *
+ * @param	sampler			Target sampler
+ *
+ * @return	void
+ */
+
+static void samplerUnit(Sampler sampler) {
+	double rate, delta;
+
+	rate = (double)sampler->unit_hits / (double)sampler->unit;
+	sampler->stats.units++;
+	sampler->stats.hits += sampler->unit_hits;
+	delta = rate - sampler->mean;
+	sampler->mean += delta / (double)sampler->stats.units;
+	sampler->m2 += delta * (rate - sampler->mean);
+	sampler->unit_hits = 0;
+}
+
+/* samplerCreate
+ *
+ * Creates a sampler that runs accesses through a cache. The cache must
+ * not use OPT. Returns NULL on failure.
+ *
+ * @param	cache			Cache to simulate, geometry already set
+ * @param	unit			Accesses simulated in detail per period
+ * @param	period			Accesses per period, at least unit
+ * @param	warm			Accesses before each unit that warm the
+ *							cache, 0 to warm with every access
+ *
+ * @return	success			sampler
+ * @return	failure			NULL
+ */
+
+Sampler samplerCreate(Cache cache, long long unit, long long period, long long warm) {
+	Sampler sampler;
+
+	if(cache == NULL || unit < 1 || period < unit || warm < 0) {
+		return NULL;
+	}
+
+	sampler = (Sampler) calloc(1, sizeof(struct Sampler_));
+	if(sampler == NULL) {
+		return NULL;
+	}
+	sampler->cache = cache;
+	sampler->unit = unit;
+	sampler->period = period;
+	sampler->warm = warm;
+
+	return(sampler);
+}
+
+/* samplerDestroy
+ *
+ * Frees a sampler, but not its cache. Passing NULL does nothing.
+ *
+ * @param	sampler			Target sampler
+ *
+ * @return	void
+ */
+
+void samplerDestroy(Sampler sampler) {
+	free(sampler);
+}
+
+/* samplerAccess
+ *
+ * Runs one access in detail, as functional warming, or not at all,
+ * depending on where it falls in its period.
+ *
+ * @param	sampler			Target sampler
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	void
+ */
+
+void samplerAccess(Sampler sampler, unsigned long long address, int write) {
+	long long start;
+
+	start = sampler->period - sampler->unit;
+	if(sampler->position >= start) {
+		sampler->unit_hits += cacheAccessNext(sampler->cache, address, write, CACHE_NEVER);
+		sampler->stats.detailed++;
+	}
+	else if(sampler->warm == 0 || sampler->position >= start - sampler->warm) {
+		cacheWarm(sampler->cache, address, write);
+		sampler->stats.warmed++;
+	}
+	else {
+		sampler->stats.skipped++;
+	}
+	sampler->stats.accesses++;
+
+	sampler->position++;
+	if(sampler->position == sampler->period) {
+		samplerUnit(sampler);
+		sampler->position = 0;
+	}
+}
+
+/* samplerGetStats
+ *
+ * Works out the estimate, its confidence interval, and how many units
+ * an error target needs.
+ *
+ * @param	sampler			Target sampler
+ * @param	target			Relative error target, such as 0.03
+ * @param	stats			Filled in with the results
+ *
+ * @return	void
+ */
+
+void samplerGetStats(Sampler sampler, double target, SampleStats *stats) {
+	double population, variance, needed;
+	long long units;
+
+	*stats = sampler->stats;
+	units = stats->units;
+	stats->hit_rate = sampler->mean;
+	stats->half_width = 0;
+	stats->error = 0;
+	stats->units_needed = 0;
+	if(units < 2) {
+		return;
+	}
+
+	/* The units are drawn from every unit sized stretch of the trace */
+	population = (double)(stats->accesses / sampler->unit);
+	variance = sampler->m2 / (double)(units - 1);
+	stats->half_width = SAMPLE_Z * sqrt(variance / (double)units
+		* (1.0 - (double)units / population));
+	if(stats->hit_rate > 0) {
+		stats->error = stats->half_width / stats->hit_rate;
+
+		/* n = (z * s / (e * mean))^2, less the correction */
+		needed = SAMPLE_Z * sqrt(variance) / (target * stats->hit_rate);
+		needed *= needed;
+		needed /= 1.0 + needed / population;
+		stats->units_needed = (long long)ceil(needed);
+		if(stats->units_needed < 2) {
+			stats->units_needed = 2;
+		}
+	}
+	else if(stats->half_width > 0) {
+		stats->error = HUGE_VAL;
+	}
+}
+
+/* END OF FILE */
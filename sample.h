@@ -0,0 +1,117 @@
+/* Description: Sampled simulation of one cache, in the style of SMARTS.
+ *  The trace is cut into periods of a fixed number of accesses, and
+ *  only the last unit of each period is simulated in detail. The rest
+ *  of the period only warms the cache, or is skipped outright when
+ *  warming is limited to the accesses just before each unit. The hit
+ *  rates of the units estimate the hit rate of the whole trace, with a
+ *  confidence interval that says how far off the estimate may be.
+ */
+
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include "cache_sim.h"
+
+/* Standard score of the confidence interval: 99.7%, as SMARTS uses */
+#define SAMPLE_Z			3.0
+
+/* Relative error target in percent, when none is given */
+#define SAMPLE_ERROR		3.0
+
+/* Warm window in multiples of the cache's blocks, when none is given */
+#define SAMPLE_WARM_BLOCKS	4
+
+/* Typedefs */
+typedef struct Sampler_* Sampler;
+typedef struct SampleStats_ SampleStats;
+
+/* SampleStats
+ *
+ * Results of a sampled run. A unit cut short by the end of the trace
+ * is simulated but left out of the estimate.
+ *
+ * @param	accesses		# of accesses seen
+ * @param	detailed		# of accesses simulated in detail
+ * @param	warmed			# of accesses that only warmed the cache
+ * @param	skipped			# of accesses not simulated at all
+ * @param	units			# of whole units measured
+ * @param	hits			# of hits in the whole units
+ * @param	hit_rate		Estimated hit rate, the mean of the units
+ * @param	half_width		Half the width of the confidence interval
+ * @param	error			half_width relative to hit_rate
+ * @param	units_needed	Fewest units that would meet the error
+ *							target, 0 if there are too few to tell
+ */
+
+struct SampleStats_ {
+	long long accesses;
+	long long detailed;
+	long long warmed;
+	long long skipped;
+	long long units;
+	long long hits;
+	double hit_rate;
+	double half_width;
+	double error;
+	long long units_needed;
+};
+
+/* samplerCreate
+ *
+ * Creates a sampler that runs accesses through a cache. The cache must
+ * not use OPT. Returns NULL on failure.
+ *
+ * @param	cache			Cache to simulate, geometry already set
+ * @param	unit			Accesses simulated in detail per period
+ * @param	period			Accesses per period, at least unit
+ * @param	warm			Accesses before each unit that warm the
+ *							cache, 0 to warm with every access
+ *
+ * @return	success			sampler
+ * @return	failure			NULL
+ */
+
+Sampler samplerCreate(Cache cache, long long unit, long long period, long long warm);
+
+/* samplerDestroy
+ *
+ * Frees a sampler, but not its cache. Passing NULL does nothing.
+ *
+ * @param	sampler			Target sampler
+ *
+ * @return	void
+ */
+
+void samplerDestroy(Sampler sampler);
+
+/* samplerAccess
+ *
+ * Runs one access in detail, as functional warming, or not at all,
+ * depending on where it falls in its period.
+ *
+ * @param	sampler			Target sampler
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ *
+ * @return	void
+ */
+
+void samplerAccess(Sampler sampler, unsigned long long address, int write);
+
+/* samplerGetStats
+ *
+ * Works out the estimate, its confidence interval, and how many units
+ * an error target needs.
+ *
+ * @param	sampler			Target sampler
+ * @param	target			Relative error target, such as 0.03
+ * @param	stats			Filled in with the results
+ *
+ * @return	void
+ */
+
+void samplerGetStats(Sampler sampler, double target, SampleStats *stats);
+
+#endif
+
+/* END OF FILE */
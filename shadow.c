@@ -0,0 +1,189 @@
+/* Description: Fully associative LRU shadow cache, kept as a hash map
+ *  from block to slot plus a doubly linked list of slots in recency
+ *  order, so every access takes O(1) time.
+ */
+
+/* Libraries */
+#include <stdlib.h>
+#include "hashmap.h"
+#include "shadow.h"
+
+/* Structs */
+
+/* Shadow
+ *
+ * Slots are linked from most to least recently used. The map keeps
+ * every block ever accessed, with a value of slot + 1 while the block
+ * is held and 0 once it has been evicted, so one lookup tells apart a
+ * first touch, a hit, and a miss.
+ *
+ * @param	capacity		Number of slots
+ * @param	used			Number of slots filled so far
+ * @param	head			Most recently used slot, -1 if none
+ * @param	tail			Least recently used slot, -1 if none
+ * @param	blocks			Block held by each slot
+ * @param	prev			Slot used just after each slot, -1 if none
+ * @param	next			Slot used just before each slot, -1 if none
+ * @param	map				Block # to slot + 1, or 0 if evicted
+ */
+
+struct Shadow_ {
+	long capacity;
+	long used;
+	long head;
+	long tail;
+	unsigned long long *blocks;
+	long *prev;
+	long *next;
+	HashMap map;
+};
+
+/* shadowUnlink
+ *
+ * Takes a slot out of the recency list.
+ *
+ * @param	shadow			Target shadow cache
+ * @param	slot			Slot to take out
+ *
+ * @return	void
+ */
+
+static void shadowUnlink(Shadow shadow, long slot) {
+	if(shadow->prev[slot] >= 0) {
+		shadow->next[shadow->prev[slot]] = shadow->next[slot];
+	}
+	else {
+		shadow->head = shadow->next[slot];
+	}
+	if(shadow->next[slot] >= 0) {
+		shadow->prev[shadow->next[slot]] = shadow->prev[slot];
+	}
+	else {
+		shadow->tail = shadow->prev[slot];
+	}
+}
+
+/* shadowPush
+ *
+ * Puts a slot at the most recently used end of the list.
+ *
+ * @param	shadow			Target shadow cache
+ * @param	slot			Slot to put in
+ *
+ * @return	void
+ */
+
+static void shadowPush(Shadow shadow, long slot) {
+	shadow->prev[slot] = -1;
+	shadow->next[slot] = shadow->head;
+	if(shadow->head >= 0) {
+		shadow->prev[shadow->head] = slot;
+	}
+	else {
+		shadow->tail = slot;
+	}
+	shadow->head = slot;
+}
+
+/* shadowCreate
+ *
+ * Creates an empty shadow cache. Returns NULL on failure.
+ *
+ * @param	capacity		Number of blocks the shadow cache holds
+ *
+ * @return	success			shadow
+ * @return	failure			NULL
+ */
+
+Shadow shadowCreate(long capacity) {
+	Shadow shadow;
+
+	shadow = (Shadow) malloc(sizeof(struct Shadow_));
+	if(shadow == NULL) {
+		return NULL;
+	}
+
+	shadow->capacity = capacity;
+	shadow->used = 0;
+	shadow->head = -1;
+	shadow->tail = -1;
+	shadow->blocks = (unsigned long long *) malloc(sizeof(unsigned long long) * capacity);
+	shadow->prev = (long *) malloc(sizeof(long) * capacity);
+	shadow->next = (long *) malloc(sizeof(long) * capacity);
+	shadow->map = hashMapCreate(capacity * 2);
+	if(shadow->blocks == NULL || shadow->prev == NULL || shadow->next == NULL
+		|| shadow->map == NULL) {
+		shadowDestroy(shadow);
+		return NULL;
+	}
+
+	return(shadow);
+}
+
+/* shadowDestroy
+ *
+ * Frees a shadow cache. Passing NULL does nothing.
+ *
+ * @param	shadow			Target shadow cache
+ *
+ * @return	void
+ */
+
+void shadowDestroy(Shadow shadow) {
+	if(shadow != NULL) {
+		free(shadow->blocks);
+		free(shadow->prev);
+		free(shadow->next);
+		hashMapDestroy(shadow->map);
+		free(shadow);
+	}
+}
+
+/* shadowAccess
+ *
+ * Accesses one main memory block, making it the most recently used
+ * block and evicting the least recently used one if the shadow cache
+ * is full. Takes O(1) time.
+ *
+ * @param	shadow			Target shadow cache
+ * @param	block			Main memory block #
+ *
+ * @return	first touch		SHADOW_NEW
+ * @return	hit				SHADOW_HIT
+ * @return	miss			SHADOW_MISS
+ */
+
+int shadowAccess(Shadow shadow, unsigned long long block) {
+	unsigned long long *value, *evicted;
+	long slot;
+	int added, result;
+
+	value = hashMapInsert(shadow->map, block, &added);
+	if(!added && *value != 0) {
+		slot = (long)*value - 1;
+		if(slot != shadow->head) {
+			shadowUnlink(shadow, slot);
+			shadowPush(shadow, slot);
+		}
+		return(SHADOW_HIT);
+	}
+	result = added ? SHADOW_NEW : SHADOW_MISS;
+
+	/* Fill a free slot, else reuse the least recently used one */
+	if(shadow->used < shadow->capacity) {
+		slot = shadow->used++;
+	}
+	else {
+		slot = shadow->tail;
+		shadowUnlink(shadow, slot);
+		evicted = hashMapFind(shadow->map, shadow->blocks[slot]);
+		*evicted = 0;
+	}
+	shadow->blocks[slot] = block;
+	shadowPush(shadow, slot);
+	*value = (unsigned long long)slot + 1;
+
+	return(result);
+}
+
+/* END OF FILE */
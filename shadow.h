@@ -0,0 +1,58 @@
+/* Description: Fully associative LRU shadow cache, used to sort the
+ *  misses of a real cache into compulsory, capacity, and conflict
+ *  misses. It also remembers every block it has ever seen.
+ */
+
+#ifndef SHADOW_H
+#define SHADOW_H
+
+/* Results of shadowAccess */
+#define SHADOW_NEW		0
+#define SHADOW_HIT		1
+#define SHADOW_MISS		2
+
+/* Typedefs */
+typedef struct Shadow_* Shadow;
+
+/* shadowCreate
+ *
+ * Creates an empty shadow cache. Returns NULL on failure.
+ *
+ * @param	capacity		Number of blocks the shadow cache holds
+ *
+ * @return	success			shadow
+ * @return	failure			NULL
+ */
+
+Shadow shadowCreate(long capacity);
+
+/* shadowDestroy
+ *
+ * Frees a shadow cache. Passing NULL does nothing.
+ *
+ * @param	shadow			Target shadow cache
+ *
+ * @return	void
+ */
+
+void shadowDestroy(Shadow shadow);
+
+/* shadowAccess
+ *
+ * Accesses one main memory block, making it the most recently used
+ * block and evicting the least recently used one if the shadow cache
+ * is full. Takes O(1) time.
+ *
+ * @param	shadow			Target shadow cache
+ * @param	block			Main memory block #
+ *
+ * @return	first touch		SHADOW_NEW
+ * @return	hit				SHADOW_HIT
+ * @return	miss			SHADOW_MISS
+ */
+
+int shadowAccess(Shadow shadow, unsigned long long block);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,414 @@
+/* Description: Set-sharded parallel engine for one cache. Set s of the
+ *  whole cache goes to shard s % count, where it is set s / count of
+ *  a cache with count times fewer sets. Addresses are rewritten on the
+ *  way so that the shard's cache finds the same set and tag, which
+ *  keeps every replacement decision the same as in the whole cache.
+ *  Each shard has one ring that only the parser writes and only the
+ *  shard's thread reads, so no locks are needed.
+ */
+
+/* Libraries */
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shard.h"
+
+#define SHARD_RING_SIZE		4096
+#define SHARD_BATCH			64
+
+/* Structs */
+
+/* ShardAccess
+ *
+ * One access handed from the parser to a shard.
+ *
+ * @param	next_use		Next use of the block, for OPT
+ * @param	address			Address rewritten for the shard's cache
+ * @param	write			0 = Read, 1 = Write
+ */
+
+struct ShardAccess_ {
+	unsigned long long next_use;
+	unsigned long long address;
+	int write;
+};
+
+/* Shard
+ *
+ * Cache and thread state of one shard. The parser keeps its own count
+ * of the accesses it has put in the ring and only publishes it as tail
+ * once every SHARD_BATCH accesses, to save cache line traffic.
+ *
+ * @param	shards			Shards the shard belongs to
+ * @param	cache			Cache holding the shard's sets
+ * @param	ring			Accesses waiting for the shard's thread
+ * @param	thread			The shard's thread
+ * @param	head			Number of accesses the shard has finished
+ * @param	tail			Number of accesses published to the shard
+ * @param	filled			Number of accesses put in the ring so far
+ * @param	seen			Value of head the parser last read
+ */
+
+struct Shard_ {
+	Shards shards;
+	Cache cache;
+	struct ShardAccess_ *ring;
+	pthread_t thread;
+	unsigned long long head __attribute__((aligned(64)));
+	unsigned long long tail __attribute__((aligned(64)));
+	unsigned long long filled;
+	unsigned long long seen;
+} __attribute__((aligned(64)));
+
+/* Shards
+ *
+ * @param	count			Number of shards
+ * @param	block_size		Size of each block in bytes
+ * @param	set_count		Number of sets of the whole cache
+ * @param	local_sets		Number of sets of each shard
+ * @param	decode_shift	1 if block_size and set_count are powers of 2
+ * @param	block_bits		log2 of block_size, when decode_shift is set
+ * @param	set_bits		log2 of set_count, when decode_shift is set
+ * @param	count_bits		log2 of count, when decode_shift is set
+ * @param	done			1 once the parser has handed out everything
+ * @param	shards			The shards
+ */
+
+struct Shards_ {
+	int count;
+	unsigned int block_size;
+	unsigned int set_count;
+	unsigned int local_sets;
+	int decode_shift;
+	int block_bits;
+	int set_bits;
+	int count_bits;
+	int done __attribute__((aligned(64)));
+	struct Shard_ *shards;
+};
+
+/* bitsOf
+ *
+ * Gives log2 of a power of 2.
+ *
+ * @param	n				Power of 2
+ *
+ * @return	bits			log2 of n
+ */
+
+static int bitsOf(unsigned int n) {
+	int bits = 0;
+
+	while((1u << bits) < n) {
+		bits++;
+	}
+
+	return(bits);
+}
+
+/* shardWorker
+ *
+ * Thread body of one shard. Runs accesses from its ring through its
+ * cache until the parser is done and the ring is empty.
+ *
+ * @param	arg				The Shard
+ *
+ * @return	NULL
+ */
+
+static void *shardWorker(void *arg) {
+	struct Shard_ *shard = (struct Shard_ *)arg;
+	struct ShardAccess_ *access;
+	unsigned long long head, tail;
+
+	head = shard->head;
+	for(;;) {
+		tail = __atomic_load_n(&shard->tail, __ATOMIC_ACQUIRE);
+		if(head == tail) {
+			if(__atomic_load_n(&shard->shards->done, __ATOMIC_ACQUIRE)
+				&& head == __atomic_load_n(&shard->tail, __ATOMIC_ACQUIRE)) {
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+
+		while(head != tail) {
+			access = &shard->ring[head & (SHARD_RING_SIZE - 1)];
+			cacheAccessNext(shard->cache, access->address, access->write, access->next_use);
+			head++;
+		}
+		__atomic_store_n(&shard->head, head, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+}
+
+/* shardsPush
+ *
+ * Finds the shard owning the set of an access and puts the access in
+ * its ring, waiting while the ring is full.
+ *
+ * @param	shards			Target shards
+ * @param	address			Integer address
+ * @param	write			0 = Read, 1 = Write
+ * @param	next_use		Next use of the block, for OPT
+ *
+ * @return	void
+ */
+
+static void shardsPush(Shards shards, unsigned long long address, int write,
+	unsigned long long next_use) {
+	struct Shard_ *shard;
+	struct ShardAccess_ *access;
+	unsigned long long mm_block, tag;
+	unsigned int set, local;
+
+	if(shards->decode_shift) {
+		mm_block = address >> shards->block_bits;
+		set = (unsigned int)(mm_block & (shards->set_count - 1));
+		tag = mm_block >> shards->set_bits;
+		shard = &shards->shards[set & (unsigned int)(shards->count - 1)];
+		local = set >> shards->count_bits;
+	}
+	else {
+		mm_block = address / shards->block_size;
+		set = (unsigned int)(mm_block % shards->set_count);
+		tag = mm_block / shards->set_count;
+		shard = &shards->shards[set % (unsigned int)shards->count];
+		local = set / (unsigned int)shards->count;
+	}
+
+	if(shard->filled - shard->seen == SHARD_RING_SIZE) {
+		__atomic_store_n(&shard->tail, shard->filled, __ATOMIC_RELEASE);
+		for(;;) {
+			shard->seen = __atomic_load_n(&shard->head, __ATOMIC_ACQUIRE);
+			if(shard->filled - shard->seen < SHARD_RING_SIZE) {
+				break;
+			}
+			sched_yield();
+		}
+	}
+
+	access = &shard->ring[shard->filled & (SHARD_RING_SIZE - 1)];
+	access->address = (tag * shards->local_sets + local) * shards->block_size;
+	access->write = write;
+	access->next_use = next_use;
+	shard->filled++;
+	if((shard->filled & (SHARD_BATCH - 1)) == 0) {
+		__atomic_store_n(&shard->tail, shard->filled, __ATOMIC_RELEASE);
+	}
+}
+
+/* shardsFinish
+ *
+ * Publishes what is left in every ring, tells the shards the parser
+ * is done, and waits for the first started shard threads to finish.
+ *
+ * @param	shards			Target shards
+ * @param	started			Number of shard threads to wait for
+ *
+ * @return	void
+ */
+
+static void shardsFinish(Shards shards, int started) {
+	int i;
+
+	for(i = 0; i < started; i++) {
+		__atomic_store_n(&shards->shards[i].tail, shards->shards[i].filled, __ATOMIC_RELEASE);
+	}
+	__atomic_store_n(&shards->done, 1, __ATOMIC_RELEASE);
+	for(i = 0; i < started; i++) {
+		pthread_join(shards->shards[i].thread, NULL);
+	}
+}
+
+/* shardsCreate
+ *
+ * Splits a cache into as many shards as there are threads, or fewer
+ * so that every shard gets the same number of sets. Returns NULL on
+ * failure, or if the cache cannot be split in at least two.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of the whole cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	threads			Most shards to make, one thread each
+ *
+ * @return	success			shards
+ * @return	failure			NULL
+ */
+
+Shards shardsCreate(long long mm_size, long long cache_size, int block_size, int nSA, int rep_policy,
+	int threads) {
+	Shards shards;
+	struct Shard_ *shard;
+	int set_count, count, i;
+
+	set_count = (int)((cache_size / block_size) / nSA);
+	count = (threads < set_count) ? threads : set_count;
+	while(count > 1 && set_count % count != 0) {
+		count--;
+	}
+	if(count < 2) {
+		return NULL;
+	}
+
+	shards = (Shards) calloc(1, sizeof(struct Shards_));
+	if(shards == NULL) {
+		return NULL;
+	}
+	shards->count = count;
+	shards->block_size = (unsigned int)block_size;
+	shards->set_count = (unsigned int)set_count;
+	shards->local_sets = (unsigned int)(set_count / count);
+	shards->decode_shift = ((block_size & (block_size - 1)) == 0)
+		&& ((set_count & (set_count - 1)) == 0);
+	shards->block_bits = bitsOf(shards->block_size);
+	shards->set_bits = bitsOf(shards->set_count);
+	shards->count_bits = bitsOf((unsigned int)count);
+
+	if(posix_memalign((void **)&shards->shards, 64, sizeof(struct Shard_) * count) != 0) {
+		free(shards);
+		return NULL;
+	}
+	memset(shards->shards, 0, sizeof(struct Shard_) * count);
+
+	for(i = 0; i < count; i++) {
+		shard = &shards->shards[i];
+		shard->shards = shards;
+		shard->cache = cacheCreate((long long)shards->local_sets * nSA * block_size, block_size,
+			rep_policy);
+		shard->ring = (struct ShardAccess_ *) malloc(sizeof(struct ShardAccess_) * SHARD_RING_SIZE);
+		if(shard->cache == NULL || shard->ring == NULL) {
+			shardsDestroy(shards);
+			return NULL;
+		}
+		cacheSetGeometry(shard->cache, mm_size, nSA);
+		cacheSetShard(shard->cache, i, count);
+	}
+
+	return(shards);
+}
+
+/* shardsDestroy
+ *
+ * Frees the shards and their caches. Passing NULL does nothing.
+ *
+ * @param	shards			Target shards
+ *
+ * @return	void
+ */
+
+void shardsDestroy(Shards shards) {
+	int i;
+
+	if(shards != NULL) {
+		for(i = 0; i < shards->count; i++) {
+			cacheDestroy(shards->shards[i].cache);
+			free(shards->shards[i].ring);
+		}
+		free(shards->shards);
+		free(shards);
+	}
+}
+
+/* shardsCount
+ *
+ * Gives the number of shards the cache was split into.
+ *
+ * @param	shards			Target shards
+ *
+ * @return	count			Number of shards
+ */
+
+int shardsCount(Shards shards) {
+	return(shards->count);
+}
+
+/* shardsRun
+ *
+ * Runs accesses through the shards, each on its own thread. Streams
+ * the trace if one is given, else replays count loaded accesses with
+ * their next uses, as OPT needs. Accesses that are not R or W are
+ * counted but skipped, and markers are neither.
+ *
+ * @param	shards			Target shards
+ * @param	trace			Opened trace to stream, or NULL
+ * @param	addresses		Address of each loaded access
+ * @param	modes			Mode of each loaded access, R or W
+ * @param	next_use		Next use of each loaded access, or NULL
+ * @param	count			Number of loaded accesses
+ *
+ * @return	success			# of accesses read
+ * @return	failure			-1
+ */
+
+long shardsRun(Shards shards, Trace trace, const unsigned long long *addresses,
+	const char *modes, const unsigned long long *next_use, long count) {
+	unsigned long long address;
+	long i, read = 0;
+	char mode;
+	int started;
+
+	shards->done = 0;
+	for(started = 0; started < shards->count; started++) {
+		if(pthread_create(&shards->shards[started].thread, NULL, shardWorker,
+			&shards->shards[started]) != 0) {
+			shardsFinish(shards, started);
+			return(-1);
+		}
+	}
+
+	if(trace != NULL) {
+		while(traceNext(trace, &mode, &address)) {
+			if(mode == 'R' || mode == 'W') {
+				shardsPush(shards, address, mode == 'W', CACHE_NEVER);
+			}
+			read += (mode != TRACE_BEGIN && mode != TRACE_END);
+		}
+	}
+	else {
+		for(i = 0; i < count; i++) {
+			if(modes[i] == 'R' || modes[i] == 'W') {
+				shardsPush(shards, addresses[i], modes[i] == 'W',
+					(next_use != NULL) ? next_use[i] : CACHE_NEVER);
+			}
+			read += (modes[i] != TRACE_BEGIN && modes[i] != TRACE_END);
+		}
+	}
+	shardsFinish(shards, shards->count);
+
+	return(read);
+}
+
+/* shardsGetStats
+ *
+ * Adds up the counters of every shard.
+ *
+ * @param	shards			Target shards
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void shardsGetStats(Shards shards, CacheStats *stats) {
+	CacheStats shard;
+	int i;
+
+	memset(stats, 0, sizeof(CacheStats));
+	for(i = 0; i < shards->count; i++) {
+		cacheGetStats(shards->shards[i].cache, &shard);
+		stats->hits += shard.hits;
+		stats->misses += shard.misses;
+		stats->reads += shard.reads;
+		stats->writes += shard.writes;
+		stats->compulsory += shard.compulsory;
+		stats->capacity += shard.capacity;
+		stats->conflict += shard.conflict;
+	}
+}
+
+/* END OF FILE */
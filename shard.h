@@ -0,0 +1,95 @@
+/* Description: Set-sharded parallel engine for one cache. Sets never
+ *  share blocks, so the sets of a cache are split among threads and
+ *  each thread simulates its sets as a smaller cache of its own. The
+ *  calling thread parses the trace and hands every access to the
+ *  thread owning its set through a lock-free ring, in trace order, so
+ *  the merged counters match a serial run exactly.
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "cache_sim.h"
+#include "trace.h"
+
+/* Typedefs */
+typedef struct Shards_* Shards;
+
+/* shardsCreate
+ *
+ * Splits a cache into as many shards as there are threads, or fewer
+ * so that every shard gets the same number of sets. Returns NULL on
+ * failure, or if the cache cannot be split in at least two.
+ *
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of the whole cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	threads			Most shards to make, one thread each
+ *
+ * @return	success			shards
+ * @return	failure			NULL
+ */
+
+Shards shardsCreate(long long mm_size, long long cache_size, int block_size, int nSA, int rep_policy,
+	int threads);
+
+/* shardsDestroy
+ *
+ * Frees the shards and their caches. Passing NULL does nothing.
+ *
+ * @param	shards			Target shards
+ *
+ * @return	void
+ */
+
+void shardsDestroy(Shards shards);
+
+/* shardsCount
+ *
+ * Gives the number of shards the cache was split into.
+ *
+ * @param	shards			Target shards
+ *
+ * @return	count			Number of shards
+ */
+
+int shardsCount(Shards shards);
+
+/* shardsRun
+ *
+ * Runs accesses through the shards, each on its own thread. Streams
+ * the trace if one is given, else replays count loaded accesses with
+ * their next uses, as OPT needs. Accesses that are not R or W are
+ * counted but skipped, and markers are neither.
+ *
+ * @param	shards			Target shards
+ * @param	trace			Opened trace to stream, or NULL
+ * @param	addresses		Address of each loaded access
+ * @param	modes			Mode of each loaded access, R or W
+ * @param	next_use		Next use of each loaded access, or NULL
+ * @param	count			Number of loaded accesses
+ *
+ * @return	success			# of accesses read
+ * @return	failure			-1
+ */
+
+long shardsRun(Shards shards, Trace trace, const unsigned long long *addresses,
+	const char *modes, const unsigned long long *next_use, long count);
+
+/* shardsGetStats
+ *
+ * Adds up the counters of every shard.
+ *
+ * @param	shards			Target shards
+ * @param	stats			Filled in with the counters
+ *
+ * @return	void
+ */
+
+void shardsGetStats(Shards shards, CacheStats *stats);
+
+#endif
+
+/* END OF FILE */
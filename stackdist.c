@@ -0,0 +1,347 @@
+/* Description: Single pass stack distance (Mattson) engine.
+ *
+ *  Each set keeps a Fenwick tree over time slots. A block's most recent
+ *  access owns a marked slot, so the stack distance of a block is the
+ *  number of marked slots after its own. When a set runs out of slots
+ *  the live slots are packed to the front, so the trees stay O(M) in
+ *  size and every access costs O(log M).
+ */
+
+/* Libraries */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hashmap.h"
+#include "stackdist.h"
+
+#define STACK_SET_SLOTS		16
+
+/* Structs */
+
+/* StackSet
+ *
+ * Recency state of one set.
+ *
+ * @param	time			Next free slot
+ * @param	live			Number of marked slots
+ * @param	cap				Number of slots
+ * @param	tree			Fenwick tree of marked slots, 1 based
+ * @param	owner			Block that last used each slot
+ */
+
+struct StackSet_ {
+	long time;
+	long live;
+	long cap;
+	long *tree;
+	unsigned long long *owner;
+};
+
+/* StackDist
+ *
+ * @param	block_size		Size of each block in bytes
+ * @param	set_count		Number of sets
+ * @param	decode_shift	1 if block_size and set_count are powers of 2
+ * @param	offset_bits		log2(block_size) when decode_shift is set
+ * @param	set_mask		set_count - 1
+ * @param	slot			Slot of the last access to each block
+ * @param	sets			Recency state of each set
+ * @param	hist			# of accesses at each stack distance
+ * @param	hist_size		Length of hist
+ * @param	max_distance	Largest stack distance seen
+ * @param	accesses		# of accesses
+ */
+
+struct StackDist_ {
+	int block_size;
+	int set_count;
+	int decode_shift;
+	int offset_bits;
+	unsigned int set_mask;
+	HashMap slot;
+	struct StackSet_ *sets;
+	long long *hist;
+	long hist_size;
+	long max_distance;
+	long long accesses;
+};
+
+/* stackTreeAdd
+ *
+ * Adds delta to one slot of a Fenwick tree.
+ *
+ * @param	set				Target set
+ * @param	slot			Slot to update
+ * @param	delta			Amount to add
+ *
+ * @return	void
+ */
+
+static void stackTreeAdd(struct StackSet_ *set, long slot, long delta) {
+	long i;
+
+	for(i = slot + 1; i <= set->cap; i += i & -i) {
+		set->tree[i] += delta;
+	}
+}
+
+/* stackTreeSum
+ *
+ * Counts the marked slots from 0 up to and including slot.
+ *
+ * @param	set				Target set
+ * @param	slot			Last slot to count
+ *
+ * @return	count			Number of marked slots
+ */
+
+static long stackTreeSum(struct StackSet_ *set, long slot) {
+	long i, sum = 0;
+
+	for(i = slot + 1; i > 0; i -= i & -i) {
+		sum += set->tree[i];
+	}
+
+	return(sum);
+}
+
+/* stackSetPack
+ *
+ * Moves the live slots of a set to the front, in order, and doubles
+ * the number of slots when more than half of them are live. The tree
+ * is rebuilt in linear time.
+ *
+ * @param	sd				Engine the set belongs to
+ * @param	set				Target set
+ *
+ * @return	void
+ */
+
+static void stackSetPack(StackDist sd, struct StackSet_ *set) {
+	unsigned long long *owner;
+	unsigned long long *value;
+	long cap, i, j, parent;
+
+	cap = (set->live * 2 > set->cap) ? set->cap * 2 : set->cap;
+	owner = (unsigned long long *) malloc(sizeof(unsigned long long) * cap);
+	assert(owner != NULL);
+
+	for(i = 0, j = 0; i < set->time; i++) {
+		value = hashMapFind(sd->slot, set->owner[i]);
+		if(value != NULL && *value == (unsigned long long)i) {
+			owner[j] = set->owner[i];
+			*value = j;
+			j++;
+		}
+	}
+	free(set->owner);
+	set->owner = owner;
+
+	if(cap != set->cap) {
+		free(set->tree);
+		set->tree = (long *) malloc(sizeof(long) * (cap + 1));
+		assert(set->tree != NULL);
+		set->cap = cap;
+	}
+	memset(set->tree, 0, sizeof(long) * (cap + 1));
+	for(i = 1; i <= j; i++) {
+		set->tree[i]++;
+	}
+	for(i = 1; i <= cap; i++) {
+		parent = i + (i & -i);
+		if(parent <= cap) {
+			set->tree[parent] += set->tree[i];
+		}
+	}
+	set->time = j;
+}
+
+/* stackDistCreate
+ *
+ * Creates an engine that maps addresses to blocks and sets the same
+ * way cacheCreate and cacheSetGeometry do. Use a set_count of 1 for
+ * fully associative caches. Returns NULL on failure.
+ *
+ * @param	block_size		Size of each block in bytes
+ * @param	set_count		Number of sets
+ *
+ * @return	success			engine
+ * @return	failure			NULL
+ */
+
+StackDist stackDistCreate(int block_size, int set_count) {
+	StackDist sd;
+
+	if(block_size < 1 || set_count < 1) {
+		return NULL;
+	}
+
+	sd = (StackDist) calloc(1, sizeof(struct StackDist_));
+	if(sd == NULL) {
+		return NULL;
+	}
+	sd->block_size = block_size;
+	sd->set_count = set_count;
+	sd->decode_shift = ((block_size & (block_size - 1)) == 0)
+		&& ((set_count & (set_count - 1)) == 0);
+	while((1 << sd->offset_bits) < block_size) {
+		sd->offset_bits++;
+	}
+	sd->set_mask = set_count - 1;
+
+	sd->slot = hashMapCreate(1024);
+	sd->sets = (struct StackSet_ *) calloc(set_count, sizeof(struct StackSet_));
+	sd->hist_size = 64;
+	sd->hist = (long long *) calloc(sd->hist_size, sizeof(long long));
+	if(sd->slot == NULL || sd->sets == NULL || sd->hist == NULL) {
+		stackDistDestroy(sd);
+		return NULL;
+	}
+
+	return(sd);
+}
+
+/* stackDistDestroy
+ *
+ * Frees an engine. Passing NULL does nothing.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	void
+ */
+
+void stackDistDestroy(StackDist sd) {
+	int i;
+
+	if(sd != NULL) {
+		if(sd->sets != NULL) {
+			for(i = 0; i < sd->set_count; i++) {
+				free(sd->sets[i].tree);
+				free(sd->sets[i].owner);
+			}
+		}
+		free(sd->sets);
+		hashMapDestroy(sd->slot);
+		free(sd->hist);
+		free(sd);
+	}
+}
+
+/* stackDistAccess
+ *
+ * Records one access. Runs in O(log M) time, where M is the number of
+ * distinct blocks in the set.
+ *
+ * @param	sd				Target engine
+ * @param	address			Address of the access
+ *
+ * @return	void
+ */
+
+void stackDistAccess(StackDist sd, unsigned long long address) {
+	struct StackSet_ *set;
+	unsigned long long *value, mm_block;
+	long distance;
+	int added;
+
+	if(sd->decode_shift) {
+		mm_block = address >> sd->offset_bits;
+		set = &sd->sets[mm_block & sd->set_mask];
+	}
+	else {
+		mm_block = address / (unsigned int)sd->block_size;
+		set = &sd->sets[mm_block % (unsigned int)sd->set_count];
+	}
+	sd->accesses++;
+
+	if(set->tree == NULL) {
+		set->cap = STACK_SET_SLOTS;
+		set->tree = (long *) calloc(set->cap + 1, sizeof(long));
+		set->owner = (unsigned long long *) malloc(sizeof(unsigned long long) * set->cap);
+		assert(set->tree != NULL && set->owner != NULL);
+	}
+
+	value = hashMapInsert(sd->slot, mm_block, &added);
+	if(!added) {
+		/* Blocks used since the last access sit above it in the stack */
+		distance = set->live - stackTreeSum(set, (long)*value);
+		stackTreeAdd(set, (long)*value, -1);
+		set->live--;
+		*value = ~0ull;
+
+		if(distance >= sd->hist_size) {
+			while(distance >= sd->hist_size) {
+				sd->hist_size *= 2;
+			}
+			sd->hist = (long long *) realloc(sd->hist, sizeof(long long) * sd->hist_size);
+			assert(sd->hist != NULL);
+			memset(sd->hist + sd->max_distance + 1, 0,
+				sizeof(long long) * (sd->hist_size - sd->max_distance - 1));
+		}
+		sd->hist[distance]++;
+		if(distance > sd->max_distance) {
+			sd->max_distance = distance;
+		}
+	}
+
+	if(set->time == set->cap) {
+		stackSetPack(sd, set);
+		value = hashMapFind(sd->slot, mm_block);
+	}
+	*value = set->time;
+	set->owner[set->time] = mm_block;
+	stackTreeAdd(set, set->time, 1);
+	set->time++;
+	set->live++;
+}
+
+/* stackDistAccesses
+ *
+ * Returns the number of accesses recorded.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	count			Number of accesses
+ */
+
+long long stackDistAccesses(StackDist sd) {
+	return(sd->accesses);
+}
+
+/* stackDistMaxWays
+ *
+ * Returns the smallest associativity that hits on every access that
+ * is not the first use of its block. Larger caches do no better.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	ways			Associativity
+ */
+
+long stackDistMaxWays(StackDist sd) {
+	return(sd->max_distance + 1);
+}
+
+/* stackDistHits
+ *
+ * Returns how many accesses an LRU cache with the engine's sets and
+ * block size, and the given associativity, would hit.
+ *
+ * @param	sd				Target engine
+ * @param	ways			Associativity
+ *
+ * @return	hits			Number of hits
+ */
+
+long long stackDistHits(StackDist sd, long ways) {
+	long long hits = 0;
+	long i;
+
+	for(i = 0; i < ways && i <= sd->max_distance; i++) {
+		hits += sd->hist[i];
+	}
+
+	return(hits);
+}
+
+/* END OF FILE */
@@ -0,0 +1,92 @@
+/* Description: Single pass stack distance (Mattson) engine. For every
+ *  access it works out how many other blocks of the same set were used
+ *  since the last access to its block. An LRU cache with that many sets
+ *  hits exactly when the distance is less than its associativity, so
+ *  one pass gives the hit rate of every associativity, and therefore
+ *  of every cache size with the same number of sets.
+ */
+
+#ifndef STACKDIST_H
+#define STACKDIST_H
+
+/* Typedefs */
+typedef struct StackDist_* StackDist;
+
+/* stackDistCreate
+ *
+ * Creates an engine that maps addresses to blocks and sets the same
+ * way cacheCreate and cacheSetGeometry do. Use a set_count of 1 for
+ * fully associative caches. Returns NULL on failure.
+ *
+ * @param	block_size		Size of each block in bytes
+ * @param	set_count		Number of sets
+ *
+ * @return	success			engine
+ * @return	failure			NULL
+ */
+
+StackDist stackDistCreate(int block_size, int set_count);
+
+/* stackDistDestroy
+ *
+ * Frees an engine. Passing NULL does nothing.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	void
+ */
+
+void stackDistDestroy(StackDist sd);
+
+/* stackDistAccess
+ *
+ * Records one access. Runs in O(log M) time, where M is the number of
+ * distinct blocks in the set.
+ *
+ * @param	sd				Target engine
+ * @param	address			Address of the access
+ *
+ * @return	void
+ */
+
+void stackDistAccess(StackDist sd, unsigned long long address);
+
+/* stackDistAccesses
+ *
+ * Returns the number of accesses recorded.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	count			Number of accesses
+ */
+
+long long stackDistAccesses(StackDist sd);
+
+/* stackDistMaxWays
+ *
+ * Returns the smallest associativity that hits on every access that
+ * is not the first use of its block. Larger caches do no better.
+ *
+ * @param	sd				Target engine
+ *
+ * @return	ways			Associativity
+ */
+
+long stackDistMaxWays(StackDist sd);
+
+/* stackDistHits
+ *
+ * Returns how many accesses an LRU cache with the engine's sets and
+ * block size, and the given associativity, would hit.
+ *
+ * @param	sd				Target engine
+ * @param	ways			Associativity
+ *
+ * @return	hits			Number of hits
+ */
+
+long long stackDistHits(StackDist sd, long ways);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,223 @@
+/* Description: Runs a grid of cache configurations against one trace.
+ *  The trace is decoded once into memory and every configuration gets
+ *  its own Cache, so configurations can be spread across threads.
+ */
+
+/* Libraries */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sweep.h"
+
+/* Structs */
+
+/* SweepJob
+ *
+ * Work shared by all threads of one sweep.
+ *
+ * @param	points			Points to simulate
+ * @param	point_count		Number of points
+ * @param	next			Index of the next point to hand out
+ * @param	lock			Guards next
+ * @param	mm_size			Size of main memory in bytes
+ * @param	addresses		Address of each access
+ * @param	modes			Mode of each access
+ * @param	count			Number of accesses
+ * @param	checkpoint		Warm cache every point starts from, or NULL
+ */
+
+struct SweepJob_ {
+	SweepPoint *points;
+	int point_count;
+	int next;
+	pthread_mutex_t lock;
+	long long mm_size;
+	const unsigned long long *addresses;
+	const char *modes;
+	long count;
+	Checkpoint checkpoint;
+};
+
+/* sweepPoint
+ *
+ * Simulates the whole trace on a fresh cache for one point, or on a
+ * cache restored from the checkpoint with its counters zeroed. OPT
+ * points first work out the next use of every access for their block
+ * size.
+ *
+ * @param	job				Sweep the point belongs to
+ * @param	point			Point to simulate
+ *
+ * @return	void
+ */
+
+static void sweepPoint(struct SweepJob_ *job, SweepPoint *point) {
+	Cache cache;
+	struct timespec start, end;
+	unsigned long long *next_use = NULL;
+	long i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	cache = cacheCreate(point->cache_size, point->block_size, point->rep_policy);
+	if(cache == NULL) {
+		point->seconds = -1;
+		return;
+	}
+	cacheSetGeometry(cache, job->mm_size, point->nSA);
+	if(job->checkpoint != NULL) {
+		if(!checkpointRestore(job->checkpoint, cache)) {
+			cacheDestroy(cache);
+			point->seconds = -1;
+			return;
+		}
+		cacheResetStats(cache);
+	}
+
+	if(point->rep_policy == CACHE_OPT) {
+		next_use = (unsigned long long *) malloc(sizeof(unsigned long long) * (job->count + 1));
+		if(next_use == NULL || !cacheNextUse(cache, job->addresses, job->modes, job->count, next_use)) {
+			free(next_use);
+			cacheDestroy(cache);
+			point->seconds = -1;
+			return;
+		}
+	}
+
+	for(i = 0; i < job->count; i++) {
+		if(job->modes[i] == 'R' || job->modes[i] == 'W') {
+			cacheAccessNext(cache, job->addresses[i], job->modes[i] == 'W',
+				next_use != NULL ? next_use[i] : CACHE_NEVER);
+		}
+	}
+	cacheGetStats(cache, &point->stats);
+	cacheDestroy(cache);
+	free(next_use);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	point->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+/* sweepWorker
+ *
+ * Thread body. Takes points until none are left.
+ *
+ * @param	arg				The SweepJob
+ *
+ * @return	NULL
+ */
+
+static void *sweepWorker(void *arg) {
+	struct SweepJob_ *job = (struct SweepJob_ *)arg;
+	int i;
+
+	for(;;) {
+		pthread_mutex_lock(&job->lock);
+		i = job->next++;
+		pthread_mutex_unlock(&job->lock);
+		if(i >= job->point_count) {
+			break;
+		}
+		sweepPoint(job, &job->points[i]);
+	}
+
+	return NULL;
+}
+
+/* sweepRun
+ *
+ * Simulates every point against the same decoded trace. Points are
+ * handed out to a pool of threads one at a time, so the sweep takes
+ * about as long as its slowest point when there are enough threads.
+ * With a checkpoint, every point starts from the blocks it saved and
+ * counts only the accesses after it. Points the checkpoint does not
+ * fit fail.
+ *
+ * @param	points			Points to simulate, results are filled in
+ * @param	point_count		Number of points
+ * @param	mm_size			Size of main memory in bytes
+ * @param	addresses		Address of each access
+ * @param	modes			Mode of each access, R or W
+ * @param	count			Number of accesses
+ * @param	threads			Number of threads to use
+ * @param	checkpoint		Warm cache to start from, NULL to start cold
+ *
+ * @return	void
+ */
+
+void sweepRun(SweepPoint *points, int point_count, long long mm_size,
+	const unsigned long long *addresses, const char *modes, long count, int threads,
+	Checkpoint checkpoint) {
+	struct SweepJob_ job;
+	pthread_t *pool;
+	int i, started = 0;
+
+	job.points = points;
+	job.point_count = point_count;
+	job.next = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	job.mm_size = mm_size;
+	job.addresses = addresses;
+	job.modes = modes;
+	job.count = count;
+	job.checkpoint = checkpoint;
+
+	if(threads > point_count) {
+		threads = point_count;
+	}
+	pool = (pthread_t *) malloc(sizeof(pthread_t) * (threads > 0 ? threads : 1));
+	if(pool != NULL) {
+		for(i = 1; i < threads; i++) {
+			if(pthread_create(&pool[started], NULL, sweepWorker, &job) == 0) {
+				started++;
+			}
+		}
+	}
+
+	/* The calling thread works too, so a sweep never stalls */
+	sweepWorker(&job);
+
+	for(i = 0; i < started; i++) {
+		pthread_join(pool[i], NULL);
+	}
+	free(pool);
+	pthread_mutex_destroy(&job.lock);
+}
+
+/* sweepPrint
+ *
+ * Prints the results of a sweep as one tab separated table. Each
+ * point's accesses are the reads and writes it simulated, so region
+ * markers in the trace are not counted.
+ *
+ * @param	points			Simulated points
+ * @param	point_count		Number of points
+ *
+ * @return	void
+ */
+
+void sweepPrint(SweepPoint *points, int point_count) {
+	SweepPoint *point;
+	long long accesses;
+	int i;
+
+	printf("cache_size\tblock_size\tnSA\tpolicy\taccesses\thits\tmisses\treads\twrites\thit_rate\tseconds\n");
+	for(i = 0; i < point_count; i++) {
+		point = &points[i];
+		if(point->seconds < 0) {
+			printf("%lld\t%d\t%d\t%s\tfailed\n", point->cache_size, point->block_size,
+				point->nSA, cachePolicyName(point->rep_policy));
+			continue;
+		}
+		accesses = point->stats.hits + point->stats.misses;
+		printf("%lld\t%d\t%d\t%s\t%lld\t%lld\t%lld\t%lld\t%lld\t%f\t%.3f\n",
+			point->cache_size, point->block_size, point->nSA,
+			cachePolicyName(point->rep_policy), accesses,
+			point->stats.hits, point->stats.misses, point->stats.reads, point->stats.writes,
+			accesses > 0 ? (double)point->stats.hits / (double)accesses * 100 : 0.0,
+			point->seconds);
+	}
+}
+
+/* END OF FILE */
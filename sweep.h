@@ -0,0 +1,78 @@
+/* Description: Runs a grid of cache configurations against one trace.
+ *  The trace is decoded once into memory and every configuration gets
+ *  its own Cache, so configurations can be spread across threads.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "cache_sim.h"
+#include "checkpoint.h"
+
+/* Typedefs */
+typedef struct SweepPoint_ SweepPoint;
+
+/* SweepPoint
+ *
+ * One cache configuration of a sweep and its results.
+ *
+ * @param	cache_size		Size of cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	nSA				Set-Associativity
+ * @param	rep_policy		One of the CACHE_ policy numbers
+ * @param	stats			Counters after the whole trace, or after the
+ *							checkpoint when there is one
+ * @param	seconds			Time taken to simulate this point
+ */
+
+struct SweepPoint_ {
+	long long cache_size;
+	int block_size;
+	int nSA;
+	int rep_policy;
+	CacheStats stats;
+	double seconds;
+};
+
+/* sweepRun
+ *
+ * Simulates every point against the same decoded trace. Points are
+ * handed out to a pool of threads one at a time, so the sweep takes
+ * about as long as its slowest point when there are enough threads.
+ * With a checkpoint, every point starts from the blocks it saved and
+ * counts only the accesses after it. Points the checkpoint does not
+ * fit fail.
+ *
+ * @param	points			Points to simulate, results are filled in
+ * @param	point_count		Number of points
+ * @param	mm_size			Size of main memory in bytes
+ * @param	addresses		Address of each access
+ * @param	modes			Mode of each access, R or W
+ * @param	count			Number of accesses
+ * @param	threads			Number of threads to use
+ * @param	checkpoint		Warm cache to start from, NULL to start cold
+ *
+ * @return	void
+ */
+
+void sweepRun(SweepPoint *points, int point_count, long long mm_size,
+	const unsigned long long *addresses, const char *modes, long count, int threads,
+	Checkpoint checkpoint);
+
+/* sweepPrint
+ *
+ * Prints the results of a sweep as one tab separated table. Each
+ * point's accesses are the reads and writes it simulated, so region
+ * markers in the trace are not counted.
+ *
+ * @param	points			Simulated points
+ * @param	point_count		Number of points
+ *
+ * @return	void
+ */
+
+void sweepPrint(SweepPoint *points, int point_count);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,684 @@
+/* Description: Reads memory access traces one access at a time so a
+ *  trace never has to be held in memory. Regular files are mapped
+ *  into memory and parsed in place. Pipes and standard input are read
+ *  through a buffer that is refilled as it runs out. Both text traces
+ *  and the compact binary format written by traceWriterOpen are read.
+ */
+
+/* Libraries */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.h"
+
+#define TRACE_BUFFER_SIZE	(1 << 16)
+#define TRACE_WRITE_SIZE	(1 << 16)
+#define TRACE_VARINT_MAX	10
+
+/* Binary trace header: magic, version, and three reserved bytes */
+static const char trace_magic[4] = {'C', 'S', 'T', 'B'};
+#define TRACE_VERSION		1
+#define TRACE_HEADER_SIZE	8
+
+/* Binary record ops, packed into the low bits of each record */
+#define TRACE_OP_BITS		2
+#define TRACE_OP_READ		0
+#define TRACE_OP_WRITE		1
+#define TRACE_OP_CORE		2
+#define TRACE_OP_MARK		3
+
+/* Kinds of TRACE_OP_MARK records */
+#define TRACE_MARK_BEGIN	0
+#define TRACE_MARK_END		1
+
+/* Structs */
+
+/* Trace
+ *
+ * The text being parsed is always the range [pos, end). Everything
+ * before safe is made of whole lines, so the parser only has to ask
+ * for more input once it reaches safe.
+ *
+ * @param	fd				Open trace file
+ * @param	binary			1 = Binary trace, 0 = Text trace
+ * @param	mapped			1 = File is mapped, 0 = Read into buffer
+ * @param	eof				1 = No more input to read
+ * @param	buffer			Start of the mapping or the read buffer
+ * @param	size			Bytes mapped or allocated for buffer
+ * @param	pos				Next byte to parse
+ * @param	safe			End of the last whole line in the buffer
+ * @param	end				End of the valid bytes in the buffer
+ * @param	last			Address of the previous binary record
+ * @param	core			Core # of the last access read
+ * @param	max				Highest address an access may have
+ * @param	over			Address of the access past max that ended
+ *							the trace, if over_limit is set
+ * @param	over_limit		1 = An access past max ended the trace
+ */
+
+struct Trace_ {
+	int fd;
+	int binary;
+	int mapped;
+	int eof;
+	char *buffer;
+	size_t size;
+	const char *pos;
+	const char *safe;
+	const char *end;
+	unsigned long long last;
+	int core;
+	unsigned long long max;
+	unsigned long long over;
+	int over_limit;
+};
+
+/* TraceWriter
+ *
+ * @param	file			Binary trace being written
+ * @param	used			Bytes waiting in buffer
+ * @param	last			Address of the previous record
+ * @param	core			Core # of the previous record
+ * @param	buffer			Encoded records not yet written
+ */
+
+struct TraceWriter_ {
+	FILE *file;
+	int used;
+	unsigned long long last;
+	int core;
+	unsigned char buffer[TRACE_WRITE_SIZE];
+};
+
+/* traceFill
+ *
+ * Moves any partial line or record to the front of the read buffer
+ * and reads more input after it. The buffer is doubled when a single
+ * line does not fit, so long lines are never cut short.
+ *
+ * @param	trace			Target trace
+ *
+ * @return	void
+ */
+
+static void traceFill(Trace trace) {
+	size_t left;
+	ssize_t got;
+	const char *nl;
+
+	left = trace->end - trace->pos;
+	memmove(trace->buffer, trace->pos, left);
+	if(left == trace->size) {
+		trace->size *= 2;
+		trace->buffer = (char *) realloc(trace->buffer, trace->size);
+		if(trace->buffer == NULL) {
+			fprintf(stderr, "\nCould not grow trace buffer.");
+			exit(1);
+		}
+	}
+
+	do {
+		got = read(trace->fd, trace->buffer + left, trace->size - left);
+	} while(got < 0 && errno == EINTR);
+	if(got <= 0) {
+		trace->eof = 1;
+		got = 0;
+	}
+
+	trace->pos = trace->buffer;
+	trace->end = trace->buffer + left + got;
+	if(trace->eof || trace->binary) {
+		trace->safe = trace->end;
+	}
+	else {
+		nl = trace->end;
+		while(nl > trace->pos && nl[-1] != '\n') {
+			nl--;
+		}
+		trace->safe = nl;
+	}
+}
+
+/* traceOpen
+ *
+ * Opens a trace file for reading. Returns NULL if the file cannot
+ * be opened. A filename of "-" reads from standard input.
+ *
+ * @param	filename		Name of the trace file
+ *
+ * @return	success			trace
+ * @return	failure			NULL
+ */
+
+Trace traceOpen(char *filename) {
+	Trace trace;
+	struct stat st;
+	void *map;
+
+	trace = (Trace) malloc(sizeof(struct Trace_));
+	if(trace == NULL) {
+		return NULL;
+	}
+
+	if(strcmp(filename, "-") == 0) {
+		trace->fd = STDIN_FILENO;
+	}
+	else {
+		trace->fd = open(filename, O_RDONLY);
+	}
+	if(trace->fd < 0) {
+		free(trace);
+		return NULL;
+	}
+
+	/* Map regular files, otherwise fall back to reading a buffer */
+	trace->binary = 0;
+	trace->mapped = 0;
+	trace->eof = 0;
+	if(fstat(trace->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, trace->fd, 0);
+		if(map != MAP_FAILED) {
+			madvise(map, st.st_size, MADV_SEQUENTIAL);
+			trace->mapped = 1;
+			trace->eof = 1;
+			trace->buffer = (char *) map;
+			trace->size = st.st_size;
+			trace->pos = trace->buffer;
+			trace->safe = trace->buffer + trace->size;
+			trace->end = trace->safe;
+		}
+	}
+	if(!trace->mapped) {
+		trace->size = TRACE_BUFFER_SIZE;
+		trace->buffer = (char *) malloc(trace->size);
+		if(trace->buffer == NULL) {
+			if(trace->fd != STDIN_FILENO) {
+				close(trace->fd);
+			}
+			free(trace);
+			return NULL;
+		}
+		trace->pos = trace->buffer;
+		trace->safe = trace->buffer;
+		trace->end = trace->buffer;
+		while(trace->end - trace->pos < TRACE_HEADER_SIZE && !trace->eof) {
+			traceFill(trace);
+		}
+	}
+
+	/* Binary traces start with a header, text traces never do */
+	trace->last = 0;
+	trace->core = 0;
+	trace->max = ~0ull;
+	trace->over = 0;
+	trace->over_limit = 0;
+	if(trace->end - trace->pos >= TRACE_HEADER_SIZE
+		&& memcmp(trace->pos, trace_magic, sizeof(trace_magic)) == 0) {
+		if(trace->pos[4] != TRACE_VERSION) {
+			traceClose(trace);
+			return NULL;
+		}
+		trace->binary = 1;
+		trace->pos += TRACE_HEADER_SIZE;
+	}
+
+	return(trace);
+}
+
+/* traceStop
+ *
+ * Ends a trace early at an access past the limit, so every later read
+ * finds the end of the trace.
+ *
+ * @param	trace			Target trace
+ * @param	address			Address of the access past the limit
+ *
+ * @return	end of trace	0
+ */
+
+static int traceStop(Trace trace, unsigned long long address) {
+	trace->over = address;
+	trace->over_limit = 1;
+	trace->eof = 1;
+	trace->pos = trace->end;
+	trace->safe = trace->end;
+
+	return(0);
+}
+
+/* traceNextBinary
+ *
+ * Decodes the next record of a binary trace. Each record is a LEB128
+ * varint of (zigzag(address - last address) << 2) | op, or of
+ * (core << 2) | 2 when the core changes.
+ *
+ * @param	trace			Target trace
+ * @param	mode			Set to the access mode, R or W
+ * @param	address			Set to the access address
+ *
+ * @return	access read		1
+ * @return	end of trace	0
+ */
+
+static int traceNextBinary(Trace trace, char *mode, unsigned long long *address) {
+	const unsigned char *p, *end;
+	unsigned long long value, delta;
+	int shift;
+
+	for(;;) {
+		if(trace->end - trace->pos < TRACE_VARINT_MAX && !trace->eof) {
+			traceFill(trace);
+		}
+		p = (const unsigned char *)trace->pos;
+		end = (const unsigned char *)trace->end;
+		if(p >= end) {
+			return(0);
+		}
+
+		/* Most records with locality fit in one byte */
+		value = *p++;
+		if(value & 0x80) {
+			value &= 0x7f;
+			shift = 7;
+			do {
+				if(p >= end || shift > 63) {
+					trace->pos = trace->end;
+					return(0);
+				}
+				value |= (unsigned long long)(*p & 0x7f) << shift;
+				shift += 7;
+			} while(*p++ & 0x80);
+		}
+		trace->pos = (const char *)p;
+
+		if((value & ((1 << TRACE_OP_BITS) - 1)) == TRACE_OP_CORE) {
+			trace->core = (int)(value >> TRACE_OP_BITS);
+			continue;
+		}
+		if((value & ((1 << TRACE_OP_BITS) - 1)) == TRACE_OP_MARK) {
+			/* Other kinds are reserved for later record types */
+			if((value >> TRACE_OP_BITS) > TRACE_MARK_END) {
+				continue;
+			}
+			*mode = ((value >> TRACE_OP_BITS) == TRACE_MARK_BEGIN) ? TRACE_BEGIN : TRACE_END;
+			*address = 0;
+			return(1);
+		}
+		delta = value >> TRACE_OP_BITS;
+		trace->last += (delta >> 1) ^ -(delta & 1);
+		*mode = ((value & ((1 << TRACE_OP_BITS) - 1)) == TRACE_OP_WRITE) ? 'W' : 'R';
+		*address = trace->last;
+		if(trace->last > trace->max) {
+			return(traceStop(trace, trace->last));
+		}
+
+		return(1);
+	}
+}
+
+/* traceNext
+ *
+ * Reads the next access from a trace. The address may be decimal or
+ * hexadecimal with a 0x prefix. Parsing is done in place without
+ * copying the line. Markers are read as accesses with the mode
+ * TRACE_BEGIN or TRACE_END and address 0.
+ *
+ * @param	trace			Target trace
+ * @param	mode			Set to the access mode, R or W
+ * @param	address			Set to the access address
+ *
+ * @return	access read		1
+ * @return	end of trace	0
+ */
+
+int traceNext(Trace trace, char *mode, unsigned long long *address) {
+	const char *p, *lim;
+	unsigned long long value;
+	unsigned int digit;
+	char c;
+
+	if(trace->binary) {
+		return(traceNextBinary(trace, mode, address));
+	}
+
+	for(;;) {
+		while(trace->pos >= trace->safe && !trace->eof) {
+			traceFill(trace);
+		}
+		p = trace->pos;
+		lim = trace->safe;
+		if(p >= lim) {
+			return(0);
+		}
+
+		while(p < lim && (*p == ' ' || *p == '\t')) {
+			p++;
+		}
+		c = (p < lim) ? *p : '\n';
+
+		/* Only lines that start with a letter hold an access */
+		if((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+			*mode = c;
+			while(p < lim && *p != ' ' && *p != '\t' && *p != '\n') {
+				p++;
+			}
+			while(p < lim && (*p == ' ' || *p == '\t')) {
+				p++;
+			}
+
+			value = 0;
+			if(lim - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+				for(p += 2; p < lim; p++) {
+					c = *p;
+					if(c >= '0' && c <= '9') {
+						digit = c - '0';
+					}
+					else if(c >= 'a' && c <= 'f') {
+						digit = c - 'a' + 10;
+					}
+					else if(c >= 'A' && c <= 'F') {
+						digit = c - 'A' + 10;
+					}
+					else {
+						break;
+					}
+					value = (value << 4) | digit;
+				}
+			}
+			else {
+				for(; p < lim && (digit = (unsigned int)(*p - '0')) <= 9; p++) {
+					value = value * 10 + digit;
+				}
+			}
+			*address = value;
+
+			/* An optional third field gives the core */
+			while(p < lim && (*p == ' ' || *p == '\t')) {
+				p++;
+			}
+			value = 0;
+			for(; p < lim && (digit = (unsigned int)(*p - '0')) <= 9; p++) {
+				value = value * 10 + digit;
+			}
+			trace->core = (int)value;
+		}
+		else {
+			c = 0;
+		}
+
+		/* Move on to the next line */
+		p = memchr(p, '\n', lim - p);
+		trace->pos = (p == NULL) ? lim : p + 1;
+		if(c != 0 && (*mode == 'R' || *mode == 'W') && *address > trace->max) {
+			return(traceStop(trace, *address));
+		}
+		if(c != 0) {
+			return(1);
+		}
+	}
+}
+
+/* traceCore
+ *
+ * Gives the core that made the access last read by traceNext.
+ *
+ * @param	trace			Target trace
+ *
+ * @return	core			Core #, 0 if the trace does not give one
+ */
+
+int traceCore(Trace trace) {
+	return(trace->core);
+}
+
+/* traceSetLimit
+ *
+ * Makes the trace end at the first R or W access whose address is not
+ * below limit, so nothing past main memory reaches a cache. Whether
+ * that happened is told by traceOverLimit.
+ *
+ * @param	trace			Target trace
+ * @param	limit			Size of main memory in bytes
+ *
+ * @return	void
+ */
+
+void traceSetLimit(Trace trace, unsigned long long limit) {
+	trace->max = (limit > 0) ? limit - 1 : 0;
+}
+
+/* traceOverLimit
+ *
+ * Tells whether the trace was ended early by an access past its limit.
+ *
+ * @param	trace			Target trace
+ * @param	address			Set to the address of that access
+ *
+ * @return	ended early		1
+ * @return	not				0
+ */
+
+int traceOverLimit(Trace trace, unsigned long long *address) {
+	*address = trace->over;
+	return(trace->over_limit);
+}
+
+/* traceLoad
+ *
+ * Reads every remaining access of a trace into two arrays, so the
+ * trace can be replayed many times without parsing it again. The
+ * arrays are malloc'd and must be freed by the caller.
+ *
+ * @param	trace			Target trace
+ * @param	addresses		Set to the array of addresses
+ * @param	modes			Set to the array of modes
+ *
+ * @return	success			Number of accesses read
+ * @return	failure			-1
+ */
+
+long traceLoad(Trace trace, unsigned long long **addresses, char **modes) {
+	unsigned long long *addr_array, *new_addr;
+	char *mode_array, *new_mode;
+	long count = 0, size = 1 << 16;
+
+	addr_array = (unsigned long long *) malloc(sizeof(unsigned long long) * size);
+	mode_array = (char *) malloc(size);
+	if(addr_array == NULL || mode_array == NULL) {
+		free(addr_array);
+		free(mode_array);
+		return(-1);
+	}
+
+	while(traceNext(trace, &mode_array[count], &addr_array[count])) {
+		count++;
+		if(count == size) {
+			size *= 2;
+			new_addr = (unsigned long long *) realloc(addr_array, sizeof(unsigned long long) * size);
+			if(new_addr != NULL) {
+				addr_array = new_addr;
+			}
+			new_mode = (char *) realloc(mode_array, size);
+			if(new_mode != NULL) {
+				mode_array = new_mode;
+			}
+			if(new_addr == NULL || new_mode == NULL) {
+				free(addr_array);
+				free(mode_array);
+				return(-1);
+			}
+		}
+	}
+
+	*addresses = addr_array;
+	*modes = mode_array;
+	return(count);
+}
+
+/* traceClose
+ *
+ * Closes a trace and frees its memory. Passing NULL does nothing.
+ *
+ * @param	trace			Target trace
+ *
+ * @return	void
+ */
+
+void traceClose(Trace trace) {
+	if(trace != NULL) {
+		if(trace->mapped) {
+			munmap(trace->buffer, trace->size);
+		}
+		else {
+			free(trace->buffer);
+		}
+		if(trace->fd != STDIN_FILENO) {
+			close(trace->fd);
+		}
+		free(trace);
+	}
+}
+
+/* traceWriterFlush
+ *
+ * Writes out any encoded records waiting in the buffer.
+ *
+ * @param	writer			Target trace writer
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int traceWriterFlush(TraceWriter writer) {
+	int ok;
+
+	ok = (fwrite(writer->buffer, 1, writer->used, writer->file) == (size_t)writer->used);
+	writer->used = 0;
+
+	return(ok);
+}
+
+/* traceWriterOpen
+ *
+ * Creates a binary trace file and writes its header. Returns NULL if
+ * the file cannot be created.
+ *
+ * @param	filename		Name of the binary trace file
+ *
+ * @return	success			writer
+ * @return	failure			NULL
+ */
+
+TraceWriter traceWriterOpen(char *filename) {
+	TraceWriter writer;
+	unsigned char header[TRACE_HEADER_SIZE] = {0};
+
+	writer = (TraceWriter) malloc(sizeof(struct TraceWriter_));
+	if(writer == NULL) {
+		return NULL;
+	}
+
+	writer->file = fopen(filename, "wb");
+	if(writer->file == NULL) {
+		free(writer);
+		return NULL;
+	}
+
+	memcpy(header, trace_magic, sizeof(trace_magic));
+	header[4] = TRACE_VERSION;
+	memcpy(writer->buffer, header, TRACE_HEADER_SIZE);
+	writer->used = TRACE_HEADER_SIZE;
+	writer->last = 0;
+	writer->core = 0;
+
+	return(writer);
+}
+
+/* traceWrite
+ *
+ * Appends one access or marker to a binary trace. Only R and W
+ * accesses and TRACE_BEGIN and TRACE_END markers can be stored, other
+ * modes are rejected. The core is only written when it changes, so
+ * single core traces pay nothing for it.
+ *
+ * @param	writer			Target trace writer
+ * @param	mode			Access mode, R or W, or a marker
+ * @param	address			Access address
+ * @param	core			Core # that made the access
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int traceWrite(TraceWriter writer, char mode, unsigned long long address, int core) {
+	unsigned long long delta, value;
+	long long diff;
+
+	if((mode != 'R' && mode != 'W' && mode != TRACE_BEGIN && mode != TRACE_END) || core < 0) {
+		return(0);
+	}
+	if(writer->used > TRACE_WRITE_SIZE - 2 * TRACE_VARINT_MAX && !traceWriterFlush(writer)) {
+		return(0);
+	}
+
+	/* Markers fit in one byte and leave the address and core alone */
+	if(mode == TRACE_BEGIN || mode == TRACE_END) {
+		writer->buffer[writer->used++] = (unsigned char)((((mode == TRACE_BEGIN)
+			? TRACE_MARK_BEGIN : TRACE_MARK_END) << TRACE_OP_BITS) | TRACE_OP_MARK);
+		return(1);
+	}
+
+	if(core != writer->core) {
+		writer->core = core;
+		value = ((unsigned long long)core << TRACE_OP_BITS) | TRACE_OP_CORE;
+		while(value >= 0x80) {
+			writer->buffer[writer->used++] = (unsigned char)(value | 0x80);
+			value >>= 7;
+		}
+		writer->buffer[writer->used++] = (unsigned char)value;
+	}
+
+	diff = (long long)(address - writer->last);
+	writer->last = address;
+	delta = ((unsigned long long)diff << 1) ^ (unsigned long long)(diff >> 63);
+	value = (delta << TRACE_OP_BITS) | (mode == 'W' ? TRACE_OP_WRITE : TRACE_OP_READ);
+
+	while(value >= 0x80) {
+		writer->buffer[writer->used++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	writer->buffer[writer->used++] = (unsigned char)value;
+
+	return(1);
+}
+
+/* traceWriterClose
+ *
+ * Flushes and closes a binary trace. Passing NULL does nothing.
+ *
+ * @param	writer			Target trace writer
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int traceWriterClose(TraceWriter writer) {
+	int ok = 1;
+
+	if(writer != NULL) {
+		ok = traceWriterFlush(writer);
+		if(fclose(writer->file) != 0) {
+			ok = 0;
+		}
+		free(writer);
+	}
+
+	return(ok);
+}
+
+/* END OF FILE */
@@ -0,0 +1,176 @@
+/* Description: Reads memory access traces one access at a time so a
+ *  trace never has to be held in memory. A trace is a text file of
+ *  "<mode> <address> [core]" lines, where mode is R or W, the address
+ *  is a 64 bit decimal or hexadecimal number with a 0x prefix, and
+ *  the optional core is the decimal # of the core that made the
+ *  access, 0 if left out.
+ *  Lines that do not start with a letter, such as the access count
+ *  header and blank lines, are skipped. Regular files are memory
+ *  mapped and parsed in place. A line of just B or E is a marker, the
+ *  beginning or end of a region of interest.
+ *
+ *  Traces can also be stored in a compact binary format. A binary
+ *  trace starts with the 8 byte header "CSTB", version 1, and three
+ *  reserved bytes. Each access is then one LEB128 varint holding
+ *  (zigzag(address - previous address) << 2) | op, where op is 0 for
+ *  R and 1 for W. Op 2 holds no address; its record is (core << 2) | 2
+ *  and makes core the core of the accesses after it. Op 3 holds no
+ *  address either; its record is (kind << 2) | 3, where kind 0 is a B
+ *  marker, kind 1 an E marker, and other kinds are reserved and
+ *  skipped by readers. Deltas are 64 bit, so addresses below
+ *  2^61 round trip. traceOpen tells the two formats apart by the
+ *  header.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/* Modes of the markers around a region of interest */
+#define TRACE_BEGIN		'B'
+#define TRACE_END		'E'
+
+/* Typedefs */
+typedef struct Trace_* Trace;
+typedef struct TraceWriter_* TraceWriter;
+
+/* traceOpen
+ *
+ * Opens a trace file for reading. Returns NULL if the file cannot
+ * be opened. A filename of "-" reads from standard input.
+ *
+ * @param	filename		Name of the trace file
+ *
+ * @return	success			trace
+ * @return	failure			NULL
+ */
+
+Trace traceOpen(char *filename);
+
+/* traceNext
+ *
+ * Reads the next access from a trace. The address may be decimal or
+ * hexadecimal with a 0x prefix. Parsing is done in place without
+ * copying the line. Markers are read as accesses with the mode
+ * TRACE_BEGIN or TRACE_END and address 0.
+ *
+ * @param	trace			Target trace
+ * @param	mode			Set to the access mode, R or W
+ * @param	address			Set to the access address
+ *
+ * @return	access read		1
+ * @return	end of trace	0
+ */
+
+int traceNext(Trace trace, char *mode, unsigned long long *address);
+
+/* traceCore
+ *
+ * Gives the core that made the access last read by traceNext.
+ *
+ * @param	trace			Target trace
+ *
+ * @return	core			Core #, 0 if the trace does not give one
+ */
+
+int traceCore(Trace trace);
+
+/* traceSetLimit
+ *
+ * Makes the trace end at the first R or W access whose address is not
+ * below limit, so nothing past main memory reaches a cache. Whether
+ * that happened is told by traceOverLimit.
+ *
+ * @param	trace			Target trace
+ * @param	limit			Size of main memory in bytes
+ *
+ * @return	void
+ */
+
+void traceSetLimit(Trace trace, unsigned long long limit);
+
+/* traceOverLimit
+ *
+ * Tells whether the trace was ended early by an access past its limit.
+ *
+ * @param	trace			Target trace
+ * @param	address			Set to the address of that access
+ *
+ * @return	ended early		1
+ * @return	not				0
+ */
+
+int traceOverLimit(Trace trace, unsigned long long *address);
+
+/* traceLoad
+ *
+ * Reads every remaining access of a trace into two arrays, so the
+ * trace can be replayed many times without parsing it again. The
+ * arrays are malloc'd and must be freed by the caller.
+ *
+ * @param	trace			Target trace
+ * @param	addresses		Set to the array of addresses
+ * @param	modes			Set to the array of modes
+ *
+ * @return	success			Number of accesses read
+ * @return	failure			-1
+ */
+
+long traceLoad(Trace trace, unsigned long long **addresses, char **modes);
+
+/* traceClose
+ *
+ * Closes a trace and frees its memory. Passing NULL does nothing.
+ *
+ * @param	trace			Target trace
+ *
+ * @return	void
+ */
+
+void traceClose(Trace trace);
+
+/* traceWriterOpen
+ *
+ * Creates a binary trace file and writes its header. Returns NULL if
+ * the file cannot be created.
+ *
+ * @param	filename		Name of the binary trace file
+ *
+ * @return	success			writer
+ * @return	failure			NULL
+ */
+
+TraceWriter traceWriterOpen(char *filename);
+
+/* traceWrite
+ *
+ * Appends one access or marker to a binary trace. Only R and W
+ * accesses and TRACE_BEGIN and TRACE_END markers can be stored, other
+ * modes are rejected. The core is only written when it changes, so
+ * single core traces pay nothing for it.
+ *
+ * @param	writer			Target trace writer
+ * @param	mode			Access mode, R or W, or a marker
+ * @param	address			Access address
+ * @param	core			Core # that made the access
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int traceWrite(TraceWriter writer, char mode, unsigned long long address, int core);
+
+/* traceWriterClose
+ *
+ * Flushes and closes a binary trace. Passing NULL does nothing.
+ *
+ * @param	writer			Target trace writer
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int traceWriterClose(TraceWriter writer);
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,78 @@
+/* Description: Converts a text trace into the compact binary trace
+ *  format read by cache_sim. Region of interest markers are kept.
+ *  Accesses with a mode other than R or W cannot be stored and are
+ *  counted and dropped.
+ *
+ *  Usage: trace_convert <input trace> <output binary trace>
+ *
+ *  Build with:
+ *   cc -O2 -o trace_convert trace_convert.c trace.c
+ */
+
+/* Libraries */
+#include <stdio.h>
+#include "trace.h"
+
+int main(int argc, char **argv) {
+	Trace trace;
+	TraceWriter writer;
+	char mode;
+	unsigned long long address;
+	long count = 0, markers = 0, dropped = 0;
+
+	if(argc != 3) {
+		fprintf(stderr, "Usage: %s <input trace> <output binary trace>\n", argv[0]);
+		return(2);
+	}
+
+	trace = traceOpen(argv[1]);
+	if(trace == NULL) {
+		fprintf(stderr, "Error: Could not open file %s\n", argv[1]);
+		return(1);
+	}
+	writer = traceWriterOpen(argv[2]);
+	if(writer == NULL) {
+		fprintf(stderr, "Error: Could not create file %s\n", argv[2]);
+		traceClose(trace);
+		return(1);
+	}
+
+	while(traceNext(trace, &mode, &address)) {
+		if(traceWrite(writer, mode, address, traceCore(trace))) {
+			if(mode == TRACE_BEGIN || mode == TRACE_END) {
+				markers++;
+			}
+			else {
+				count++;
+			}
+		}
+		else if(mode != 'R' && mode != 'W' && mode != TRACE_BEGIN && mode != TRACE_END) {
+			dropped++;
+		}
+		else {
+			fprintf(stderr, "Error: Could not write file %s\n", argv[2]);
+			traceWriterClose(writer);
+			traceClose(trace);
+			return(1);
+		}
+	}
+	traceClose(trace);
+
+	if(!traceWriterClose(writer)) {
+		fprintf(stderr, "Error: Could not write file %s\n", argv[2]);
+		return(1);
+	}
+
+	printf("%ld accesses written", count);
+	if(markers > 0) {
+		printf(", %ld markers", markers);
+	}
+	if(dropped > 0) {
+		printf(", %ld accesses with other modes dropped", dropped);
+	}
+	printf("\n");
+
+	return(0);
+}
+
+/* END OF FILE */
@@ -0,0 +1,266 @@
+/* Description: Synthetic access patterns for benchmarking the cache.
+ *  Random choices come from a xorshift generator, so a seed always
+ *  gives the same accesses on every machine.
+ */
+
+/* Libraries */
+#include <math.h>
+#include <stdlib.h>
+#include <strings.h>
+#include "workload.h"
+
+#define WORKLOAD_ZIPF_EXPONENT	0.99
+
+static const char *workload_names[WORKLOAD_COUNT] = {
+	"sequential", "strided", "uniform", "zipf", "chase", "large"
+};
+
+/* workloadRandom
+ *
+ * Steps a xorshift32 generator.
+ *
+ * @param	seed			Generator state, updated
+ *
+ * @return	value			Next random number
+ */
+
+static inline unsigned int workloadRandom(unsigned int *seed) {
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return(*seed);
+}
+
+/* workloadBlocks
+ *
+ * Works out how many blocks a workload covers, keeping it within main
+ * memory.
+ *
+ * @param	bytes			Size the workload would like to cover
+ * @param	mm_size			Size of main memory in bytes
+ * @param	block_size		Size of each block in bytes
+ *
+ * @return	blocks			Number of blocks, at least 1
+ */
+
+static unsigned int workloadBlocks(unsigned long long bytes, long long mm_size,
+	int block_size) {
+	if(bytes > (unsigned long long)mm_size) {
+		bytes = (unsigned long long)mm_size;
+	}
+	bytes /= (unsigned int)block_size;
+	if(bytes > 0xFFFFFFFFull) {
+		bytes = 0xFFFFFFFFull;
+	}
+
+	return((bytes > 0) ? (unsigned int)bytes : 1);
+}
+
+/* workloadZipf
+ *
+ * Picks blocks with Zipfian popularity. The cumulative popularity of
+ * every rank is worked out once, then each access looks up a random
+ * number in it. Ranks are scattered over the blocks so the popular
+ * ones are spread over the sets.
+ *
+ * @param	addresses		Filled in with count addresses
+ * @param	count			Number of accesses
+ * @param	blocks			Number of blocks to pick from
+ * @param	block_size		Size of each block in bytes
+ * @param	seed			Generator state, updated
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int workloadZipf(unsigned long long *addresses, long count, unsigned int blocks,
+	int block_size, unsigned int *seed) {
+	double *cdf, total = 0, u;
+	unsigned int low, high, mid;
+	long i;
+
+	cdf = (double *) malloc(sizeof(double) * blocks);
+	if(cdf == NULL) {
+		return(0);
+	}
+	for(i = 0; i < blocks; i++) {
+		total += 1.0 / pow((double)(i + 1), WORKLOAD_ZIPF_EXPONENT);
+		cdf[i] = total;
+	}
+
+	for(i = 0; i < count; i++) {
+		u = (double)(workloadRandom(seed) >> 8) / 16777216.0 * total;
+		low = 0;
+		high = blocks - 1;
+		while(low < high) {
+			mid = low + (high - low) / 2;
+			if(cdf[mid] <= u) {
+				low = mid + 1;
+			}
+			else {
+				high = mid;
+			}
+		}
+		addresses[i] = ((low * 2654435761ull) % blocks) * (unsigned int)block_size;
+	}
+	free(cdf);
+
+	return(1);
+}
+
+/* workloadChase
+ *
+ * Follows a random cycle through every block, made with Sattolo's
+ * shuffle so that it visits them all before coming back.
+ *
+ * @param	addresses		Filled in with count addresses
+ * @param	count			Number of accesses
+ * @param	blocks			Number of blocks in the cycle
+ * @param	block_size		Size of each block in bytes
+ * @param	seed			Generator state, updated
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+static int workloadChase(unsigned long long *addresses, long count, unsigned int blocks,
+	int block_size, unsigned int *seed) {
+	unsigned int *next, node, j, swap;
+	long i;
+
+	next = (unsigned int *) malloc(sizeof(unsigned int) * blocks);
+	if(next == NULL) {
+		return(0);
+	}
+	for(i = 0; i < blocks; i++) {
+		next[i] = (unsigned int)i;
+	}
+	for(i = blocks - 1; i > 0; i--) {
+		j = workloadRandom(seed) % (unsigned int)i;
+		swap = next[i];
+		next[i] = next[j];
+		next[j] = swap;
+	}
+
+	node = 0;
+	for(i = 0; i < count; i++) {
+		addresses[i] = (unsigned long long)node * (unsigned int)block_size;
+		node = next[node];
+	}
+	free(next);
+
+	return(1);
+}
+
+/* workloadName
+ *
+ * Gives the name of a workload.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ *
+ * @return	success			name, such as "zipf"
+ * @return	failure			NULL
+ */
+
+const char *workloadName(int workload) {
+	if(workload < 0 || workload >= WORKLOAD_COUNT) {
+		return NULL;
+	}
+
+	return(workload_names[workload]);
+}
+
+/* workloadParse
+ *
+ * Finds a workload by name, ignoring case.
+ *
+ * @param	name			Name of the workload
+ *
+ * @return	success			One of the WORKLOAD_ numbers
+ * @return	failure			-1
+ */
+
+int workloadParse(const char *name) {
+	int i;
+
+	for(i = 0; i < WORKLOAD_COUNT; i++) {
+		if(strcasecmp(name, workload_names[i]) == 0) {
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/* workloadGenerate
+ *
+ * Fills in the addresses and modes of a workload. One access in four
+ * is a write. Addresses stay below mm_size.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ * @param	addresses		Filled in with count addresses
+ * @param	modes			Filled in with count modes, R or W
+ * @param	count			Number of accesses
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	seed			Nonzero seed of the random choices
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int workloadGenerate(int workload, unsigned long long *addresses, char *modes, long count,
+	long long mm_size, long long cache_size, int block_size, unsigned int seed) {
+	unsigned int blocks;
+	long i;
+
+	switch(workload) {
+		case WORKLOAD_SEQUENTIAL:
+			for(i = 0; i < count; i++) {
+				addresses[i] = ((unsigned long long)i * 4) % (unsigned long long)mm_size;
+			}
+			break;
+		case WORKLOAD_STRIDED:
+			blocks = workloadBlocks((unsigned long long)mm_size, mm_size, block_size * 4);
+			for(i = 0; i < count; i++) {
+				addresses[i] = (unsigned long long)(i % blocks) * (unsigned int)block_size * 4;
+			}
+			break;
+		case WORKLOAD_UNIFORM:
+			blocks = workloadBlocks(2ull * (unsigned long long)cache_size, mm_size, block_size);
+			for(i = 0; i < count; i++) {
+				addresses[i] = (unsigned long long)(workloadRandom(&seed) % blocks)
+					* (unsigned int)block_size;
+			}
+			break;
+		case WORKLOAD_ZIPF:
+			blocks = workloadBlocks(16ull * (unsigned long long)cache_size, mm_size, block_size);
+			if(!workloadZipf(addresses, count, blocks, block_size, &seed)) {
+				return(0);
+			}
+			break;
+		case WORKLOAD_CHASE:
+			blocks = workloadBlocks((unsigned long long)cache_size, mm_size, block_size);
+			if(!workloadChase(addresses, count, blocks, block_size, &seed)) {
+				return(0);
+			}
+			break;
+		case WORKLOAD_LARGE:
+			blocks = workloadBlocks(4ull * (unsigned long long)cache_size, mm_size, block_size);
+			for(i = 0; i < count; i++) {
+				addresses[i] = (unsigned long long)(i % blocks) * (unsigned int)block_size;
+			}
+			break;
+		default:
+			return(0);
+	}
+
+	for(i = 0; i < count; i++) {
+		modes[i] = ((i & 3) == 3) ? 'W' : 'R';
+	}
+
+	return(1);
+}
+
+/* END OF FILE */
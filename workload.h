@@ -0,0 +1,75 @@
+/* Description: Synthetic access patterns for benchmarking the cache.
+ *  Every workload is sized from the cache it will run against and is
+ *  fully determined by its seed, so runs can be compared over time.
+ *   sequential     Walks forward through memory one word at a time.
+ *   strided        Walks forward four blocks at a time, so every
+ *                  access is to a new block.
+ *   uniform        Picks blocks at random from twice the cache size.
+ *   zipf           Picks blocks from sixteen times the cache size with
+ *                  Zipfian popularity, exponent 0.99.
+ *   chase          Follows a random cycle through as many blocks as
+ *                  the cache holds, as walking a linked list does.
+ *   large          Loops over four times the cache size in order, a
+ *                  working set larger than the cache.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+/* Workloads */
+#define WORKLOAD_SEQUENTIAL	0
+#define WORKLOAD_STRIDED	1
+#define WORKLOAD_UNIFORM	2
+#define WORKLOAD_ZIPF		3
+#define WORKLOAD_CHASE		4
+#define WORKLOAD_LARGE		5
+#define WORKLOAD_COUNT		6
+
+/* workloadName
+ *
+ * Gives the name of a workload.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ *
+ * @return	success			name, such as "zipf"
+ * @return	failure			NULL
+ */
+
+const char *workloadName(int workload);
+
+/* workloadParse
+ *
+ * Finds a workload by name, ignoring case.
+ *
+ * @param	name			Name of the workload
+ *
+ * @return	success			One of the WORKLOAD_ numbers
+ * @return	failure			-1
+ */
+
+int workloadParse(const char *name);
+
+/* workloadGenerate
+ *
+ * Fills in the addresses and modes of a workload. One access in four
+ * is a write. Addresses stay below mm_size.
+ *
+ * @param	workload		One of the WORKLOAD_ numbers
+ * @param	addresses		Filled in with count addresses
+ * @param	modes			Filled in with count modes, R or W
+ * @param	count			Number of accesses
+ * @param	mm_size			Size of main memory in bytes
+ * @param	cache_size		Size of the cache in bytes
+ * @param	block_size		Size of each block in bytes
+ * @param	seed			Nonzero seed of the random choices
+ *
+ * @return	success			1
+ * @return	failure			0
+ */
+
+int workloadGenerate(int workload, unsigned long long *addresses, char *modes, long count,
+	long long mm_size, long long cache_size, int block_size, unsigned int seed);
+
+#endif
+
+/* END OF FILE */